@@ -34,6 +34,6 @@ echo "CC = gcc"                                               > $1/Source/makefi
 echo "CFLAGS = -DNDEBUG -O3 -Wall -Wextra -Wshadow -std=c99" >> $1/Source/makefile
 echo "SRC = *.c"                                             >> $1/Source/makefile
 echo "all:"                                                  >> $1/Source/makefile
-echo "	\$(CC) \$(CFLAGS) \$(SRC) -o $1"                     >> $1/Source/makefile
+echo "	\$(CC) \$(CFLAGS) \$(SRC) -o $1 -lpthread -lm"       >> $1/Source/makefile
 
 cd ../ 
\ No newline at end of file
@@ -0,0 +1,381 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "bitbase.h"
+#include "bitboards.h"
+#include "bitutils.h"
+#include "magics.h"
+#include "movegen.h"
+#include "piece.h"
+#include "types.h"
+
+uint64_t KPKBitbase[KPK_SIZE / 64];
+uint64_t KRKBitbase[KRK_SIZE / 64];
+
+/**
+ * Generate the KPK and KRK bitbases by retrograde analysis. The magic
+ * move tables must already be initialized, as they are used to find the
+ * moves of the kings and the rook. Each bitbase holds a single bit for
+ * each position, set when the side with the pawn or rook wins.
+ */
+void initalizeBitbases(){
+    generateKPK();
+    generateKRK();
+}
+
+/**
+ * Look up the Board in the bitbases. The position is first viewed from
+ * the side with the extra piece, as if it were white, and then mirrored
+ * onto the part of the board that the bitbase covers.
+ *
+ * @param   board   Board to look up
+ *
+ * @return          BITBASE_WIN or BITBASE_DRAW for the side with the
+ *                  extra piece, or BITBASE_UNKNOWN if not covered
+ */
+int probeBitbases(Board * board){
+    
+    uint64_t white = board->colours[WHITE];
+    uint64_t black = board->colours[BLACK];
+    uint64_t extra = board->pieces[PAWN] | board->pieces[ROOK];
+    
+    int strong, stm, strongKing, weakKing, piece, index;
+    
+    if (   popcount(white | black) != 3
+        || popcount(extra) != 1
+        || (board->pieces[PAWN] && board->pieces[ROOK]))
+        return BITBASE_UNKNOWN;
+    
+    strong = (white & extra) ? WHITE : BLACK;
+    stm = board->turn == strong ? WHITE : BLACK;
+    
+    strongKing = getLSB(board->colours[ strong] & board->pieces[KING]);
+    weakKing   = getLSB(board->colours[!strong] & board->pieces[KING]);
+    piece      = getLSB(extra);
+    
+    // View the position as if the strong side were white
+    if (strong == BLACK){
+        strongKing ^= 56;
+        weakKing   ^= 56;
+        piece      ^= 56;
+    }
+    
+    if (board->pieces[PAWN]){
+        
+        // Mirror the pawn onto the files A-D
+        if (File(piece) > 3){
+            strongKing ^= 7;
+            weakKing   ^= 7;
+            piece      ^= 7;
+        }
+        
+        index = kpkIndex(stm, strongKing, weakKing, piece);
+        return (KPKBitbase[index / 64] >> (index % 64)) & 1 ? BITBASE_WIN : BITBASE_DRAW;
+    }
+    
+    index = krkIndex(stm, strongKing, piece, weakKing);
+    return (KRKBitbase[index / 64] >> (index % 64)) & 1 ? BITBASE_WIN : BITBASE_DRAW;
+}
+
+/**
+ * Classify every KPK position, and keep reclassifying those still
+ * unknown until a full pass changes nothing. Positions which never
+ * resolve can not be won, and are drawn.
+ */
+void generateKPK(){
+    
+    int i, changed;
+    uint8_t * results = malloc(KPK_SIZE);
+    
+    for (i = 0; i < KPK_SIZE; i++)
+        results[i] = initialKPK(i);
+    
+    do {
+        changed = 0;
+        for (i = 0; i < KPK_SIZE; i++)
+            if (results[i] == BITBASE_UNKNOWN
+                && (results[i] = classifyKPK(results, i)) != BITBASE_UNKNOWN)
+                changed = 1;
+    } while (changed);
+    
+    for (i = 0; i < KPK_SIZE; i++)
+        if (results[i] == BITBASE_WIN)
+            KPKBitbase[i / 64] |= 1ull << (i % 64);
+    
+    free(results);
+}
+
+/**
+ * Compute the index of a KPK position, with white as the strong side.
+ *
+ * @param   stm         Side to move
+ * @param   strongKing  Square of the white king
+ * @param   weakKing    Square of the black king
+ * @param   pawn        Square of the pawn, on the files A-D
+ *
+ * @return              Index of the position
+ */
+int kpkIndex(int stm, int strongKing, int weakKing, int pawn){
+    return stm | (strongKing << 1) | (weakKing << 7)
+         | ((4 * (Rank(pawn) - 1) + File(pawn)) << 13);
+}
+
+/**
+ * Classify a KPK position without looking at any other position. Some
+ * positions are impossible, a pawn on the seventh which can safely move
+ * up is a win, and the weak side draws if it is stalemated or able to
+ * capture an undefended pawn.
+ *
+ * @param   index   Index of the position
+ *
+ * @return          Initial classification of the position
+ */
+int initialKPK(int index){
+    
+    int stm = index & 1;
+    int strongKing = (index >> 1) & 63;
+    int weakKing = (index >> 7) & 63;
+    int pawn = 8 + 8 * ((index >> 13) / 4) + (index >> 13) % 4;
+    int push = pawn + 8;
+    
+    uint64_t pawnAttacks = (File(pawn) > 0 ? 1ull << (pawn + 7) : 0ull)
+                         | (File(pawn) < 7 ? 1ull << (pawn + 9) : 0ull);
+    
+    if (   strongKing == weakKing
+        || strongKing == pawn
+        || weakKing == pawn
+        || (KingMap[strongKing] & (1ull << weakKing))
+        || (stm == WHITE && (pawnAttacks & (1ull << weakKing))))
+        return BITBASE_INVALID;
+    
+    if (   stm == WHITE
+        && Rank(pawn) == 6
+        && strongKing != push
+        && weakKing != push
+        && (   !(KingMap[weakKing] & (1ull << push))
+            ||  (KingMap[strongKing] & (1ull << push))))
+        return BITBASE_WIN;
+    
+    if (   stm == BLACK
+        && (   !(KingMap[weakKing] & ~(KingMap[strongKing] | pawnAttacks))
+            ||  (KingMap[weakKing] & ~KingMap[strongKing] & (1ull << pawn))))
+        return BITBASE_DRAW;
+    
+    return BITBASE_UNKNOWN;
+}
+
+/**
+ * Classify a KPK position using the classifications of the positions
+ * reached by each move. The side to move takes the best result it can
+ * reach, and the position is unknown until that result is certain.
+ *
+ * @param   results     Current classification of every position
+ * @param   index       Index of the position
+ *
+ * @return              New classification of the position
+ */
+int classifyKPK(uint8_t * results, int index){
+    
+    int stm = index & 1;
+    int strongKing = (index >> 1) & 63;
+    int weakKing = (index >> 7) & 63;
+    int pawn = 8 + 8 * ((index >> 13) / 4) + (index >> 13) % 4;
+    
+    int good = stm == WHITE ? BITBASE_WIN : BITBASE_DRAW;
+    int bad  = stm == WHITE ? BITBASE_DRAW : BITBASE_WIN;
+    int reached = BITBASE_INVALID;
+    
+    uint64_t moves = KingMap[stm == WHITE ? strongKing : weakKing];
+    
+    while (moves){
+        if (stm == WHITE)
+            reached |= results[kpkIndex(BLACK, getLSB(moves), weakKing, pawn)];
+        else
+            reached |= results[kpkIndex(WHITE, strongKing, getLSB(moves), pawn)];
+        moves &= moves - 1;
+    }
+    
+    // Pawn pushes, where blocked pushes lead to invalid positions
+    if (stm == WHITE && Rank(pawn) < 6)
+        reached |= results[kpkIndex(BLACK, strongKing, weakKing, pawn + 8)];
+    
+    if (   stm == WHITE
+        && Rank(pawn) == 1
+        && pawn + 8 != strongKing
+        && pawn + 8 != weakKing)
+        reached |= results[kpkIndex(BLACK, strongKing, weakKing, pawn + 16)];
+    
+    return (reached & good)             ? good
+         : (reached & BITBASE_UNKNOWN)  ? BITBASE_UNKNOWN : bad;
+}
+
+/**
+ * Classify every KRK position, and keep reclassifying those still
+ * unknown until a full pass changes nothing. Unlike KPK, wins are only
+ * found by reaching checkmate, so this takes one pass for each ply of
+ * the longest mate.
+ */
+void generateKRK(){
+    
+    int i, changed;
+    uint8_t * results = malloc(KRK_SIZE);
+    
+    for (i = 0; i < KRK_SIZE; i++)
+        results[i] = initialKRK(i);
+    
+    do {
+        changed = 0;
+        for (i = 0; i < KRK_SIZE; i++)
+            if (results[i] == BITBASE_UNKNOWN
+                && (results[i] = classifyKRK(results, i)) != BITBASE_UNKNOWN)
+                changed = 1;
+    } while (changed);
+    
+    for (i = 0; i < KRK_SIZE; i++)
+        if (results[i] == BITBASE_WIN)
+            KRKBitbase[i / 64] |= 1ull << (i % 64);
+    
+    free(results);
+}
+
+/**
+ * Compute the index of a KRK position, with white as the strong side.
+ * The board is mirrored so that the black king is within A1-D4.
+ *
+ * @param   stm         Side to move
+ * @param   strongKing  Square of the white king
+ * @param   rook        Square of the white rook
+ * @param   weakKing    Square of the black king
+ *
+ * @return              Index of the position
+ */
+int krkIndex(int stm, int strongKing, int rook, int weakKing){
+    
+    if (File(weakKing) > 3){
+        strongKing ^= 7;
+        rook ^= 7;
+        weakKing ^= 7;
+    }
+    
+    if (Rank(weakKing) > 3){
+        strongKing ^= 56;
+        rook ^= 56;
+        weakKing ^= 56;
+    }
+    
+    return stm | (strongKing << 1) | (rook << 7)
+         | ((4 * Rank(weakKing) + File(weakKing)) << 13);
+}
+
+/**
+ * Classify a KRK position without looking at any other position. Some
+ * positions are impossible, the weak side draws by stalemate or by
+ * capturing an undefended rook, and loses if checkmated.
+ *
+ * @param   index   Index of the position
+ *
+ * @return          Initial classification of the position
+ */
+int initialKRK(int index){
+    
+    int stm = index & 1;
+    int strongKing = (index >> 1) & 63;
+    int rook = (index >> 7) & 63;
+    int weakKing = 8 * ((index >> 13) / 4) + (index >> 13) % 4;
+    
+    uint64_t attacked, escapes;
+    uint64_t check = RookAttacks(rook, 1ull << strongKing, 1ull << weakKing);
+    
+    if (   strongKing == weakKing
+        || strongKing == rook
+        || weakKing == rook
+        || (KingMap[strongKing] & (1ull << weakKing))
+        || (stm == WHITE && check))
+        return BITBASE_INVALID;
+    
+    if (stm == BLACK){
+        
+        // The weak king may not step along the rook's lines of attack
+        attacked = KingMap[strongKing] | RookAttacks(rook, 1ull << strongKing, ~0ull);
+        escapes = KingMap[weakKing] & ~attacked;
+        
+        if (escapes & (1ull << rook))
+            return BITBASE_DRAW;
+        
+        if (!escapes)
+            return check ? BITBASE_WIN : BITBASE_DRAW;
+    }
+    
+    return BITBASE_UNKNOWN;
+}
+
+/**
+ * Classify a KRK position using the classifications of the positions
+ * reached by each move. The side to move takes the best result it can
+ * reach, and the position is unknown until that result is certain.
+ *
+ * @param   results     Current classification of every position
+ * @param   index       Index of the position
+ *
+ * @return              New classification of the position
+ */
+int classifyKRK(uint8_t * results, int index){
+    
+    int stm = index & 1;
+    int strongKing = (index >> 1) & 63;
+    int rook = (index >> 7) & 63;
+    int weakKing = 8 * ((index >> 13) / 4) + (index >> 13) % 4;
+    
+    int good = stm == WHITE ? BITBASE_WIN : BITBASE_DRAW;
+    int bad  = stm == WHITE ? BITBASE_DRAW : BITBASE_WIN;
+    int reached = BITBASE_INVALID;
+    
+    uint64_t occupied = (1ull << strongKing) | (1ull << weakKing);
+    uint64_t moves;
+    
+    if (stm == WHITE){
+        
+        moves = KingMap[strongKing];
+        while (moves){
+            reached |= results[krkIndex(BLACK, getLSB(moves), rook, weakKing)];
+            moves &= moves - 1;
+        }
+        
+        moves = RookAttacks(rook, occupied, ~occupied);
+        while (moves){
+            reached |= results[krkIndex(BLACK, strongKing, getLSB(moves), weakKing)];
+            moves &= moves - 1;
+        }
+    }
+    
+    else {
+        
+        // Capturing a defended rook leads to an invalid position
+        moves = KingMap[weakKing];
+        while (moves){
+            reached |= results[krkIndex(WHITE, strongKing, rook, getLSB(moves))];
+            moves &= moves - 1;
+        }
+    }
+    
+    return (reached & good)             ? good
+         : (reached & BITBASE_UNKNOWN)  ? BITBASE_UNKNOWN : bad;
+}
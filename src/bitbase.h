@@ -0,0 +1,54 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _BITBASE_H
+#define _BITBASE_H
+
+#include <stdint.h>
+
+#include "types.h"
+
+#define BITBASE_INVALID (0)
+#define BITBASE_UNKNOWN (1)
+#define BITBASE_DRAW    (2)
+#define BITBASE_WIN     (4)
+
+// Positions are indexed by the side to move and the squares of the
+// strong king, the weak king, and the pawn or rook. Pawns are mirrored
+// onto the files A-D, and the weak king onto the squares A1-D4 for KRK
+#define KPK_SIZE        (2 * 64 * 64 * 24)
+#define KRK_SIZE        (2 * 64 * 64 * 16)
+
+void initalizeBitbases();
+
+int probeBitbases(Board * board);
+
+void generateKPK();
+int kpkIndex(int stm, int strongKing, int weakKing, int pawn);
+int initialKPK(int index);
+int classifyKPK(uint8_t * results, int index);
+
+void generateKRK();
+int krkIndex(int stm, int strongKing, int rook, int weakKing);
+int initialKRK(int index);
+int classifyKRK(uint8_t * results, int index);
+
+extern uint64_t KPKBitbase[KPK_SIZE / 64];
+extern uint64_t KRKBitbase[KRK_SIZE / 64];
+
+#endif
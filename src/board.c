@@ -16,7 +16,10 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <inttypes.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
 #include <string.h>
 
@@ -24,16 +27,19 @@
 #include "bitutils.h"
 #include "board.h"
 #include "castle.h"
+#include "history.h"
 #include "magics.h"
 #include "masks.h"
 #include "piece.h"
 #include "psqt.h"
 #include "search.h"
-#include "time.h"
+#include "stats.h"
+#include "timer.h"
 #include "transposition.h"
 #include "types.h"
 #include "move.h"
 #include "movegen.h"
+#include "uci.h"
 #include "zorbist.h"
 
 #define NUM_BENCHMARKS (21)
@@ -62,6 +68,15 @@ char Benchmarks[NUM_BENCHMARKS][256] = { // StockFish:benchmark.cpp
 	"6k1/4pp1p/3p2p1/P1pPb3/R7/1r2P1PP/3B1P2/6K1 w - - 0 1",
 };
 
+int BenchDepth, BenchThreads, BenchNext;
+pthread_mutex_t BenchLock = PTHREAD_MUTEX_INITIALIZER;
+
+SearchStats BenchStats;
+
+uint16_t BenchMoves[NUM_BENCHMARKS];
+uint64_t BenchNodes[NUM_BENCHMARKS];
+double BenchTimes[NUM_BENCHMARKS];
+
 /**
  * Initalize a given board struct based on the passed FEN position
  *
@@ -172,8 +187,8 @@ void initalizeBoard(Board * board, char * fen){
     // Update the enpass square to reflect not only a potential
     // enpass, but that an enpass is actually possible
     if (board->epSquare != -1){
-        enemyPawns = board->colours[!board->turn] & board->pieces[PAWN];
-        enemyPawns &= IsolatedPawnMasks[board->epSquare];;
+        enemyPawns = board->colours[board->turn] & board->pieces[PAWN];
+        enemyPawns &= IsolatedPawnMasks[board->epSquare];
         enemyPawns &= (board->turn == BLACK) ? RANK_4 : RANK_5;
         if (enemyPawns == 0ull) board->epSquare = -1;
     }
@@ -201,6 +216,8 @@ void initalizeBoard(Board * board, char * fen){
     
     // Number of moves since this position
     board->numMoves = 0;
+    board->pliesFromNull = 0;
+    memset(board->repetitionFilter, 0, sizeof(board->repetitionFilter));
     
     // We cannot actually determine whether or not a castle took
     // place, but we do not care, as we only put value on castles
@@ -281,34 +298,147 @@ uint64_t perft(Board * board, int depth){
 }
 
 /**
- * Search each of the benchmark positions to a given depth.
- * Quick way of checking non functional speedups.
+ * Search each of the benchmark positions to a given depth, and report
+ * the nodes and time used for each. Every worker has a transposition
+ * table of its own, the size of the main table, which is cleared before
+ * each position. The total node count and the signature are therefore
+ * reproducible for any number of threads, and can be used to verify that
+ * a change is non functional. With more threads, positions are searched
+ * concurrently to measure how the engine scales.
  *
- * @param   depth   Search depth for each position
+ * @param   depth       Search depth for each position
+ * @param   nthreads    Number of positions to search at once
  */
-void runBenchmark(int depth){
+void runBenchmark(int depth, int nthreads){
 
     int i;
-    double start, end;
+    double start, elapsed;
+    uint64_t nodes = 0ull, signature = 0ull;
+    char moveStr[6];
+    
+    Thread * threads;
+    TransTable * tables;
+    pthread_t * pthreads;
+    uint64_t megabytes = (Table.numBuckets * sizeof(TransBucket)) >> 20;
+    
+    BenchDepth = depth > 0 ? depth : BENCH_DEPTH;
+    BenchThreads = nthreads > 0 ? nthreads : 1;
+    BenchNext = 0;
+    
+    threads = calloc(BenchThreads, sizeof(Thread));
+    tables = calloc(BenchThreads, sizeof(TransTable));
+    pthreads = malloc(BenchThreads * sizeof(pthread_t));
+    
+    // Workers never share a table, so their searches cannot interact
+    for (i = 0; i < BenchThreads; i++){
+        initalizeTranspositionTable(&tables[i], megabytes);
+        threads[i].table = &tables[i];
+    }
+    
+    clearStatistics(&BenchStats);
     
-    SearchInfo info;
-    info.searchIsInfinite = 0;
-    info.searchIsDepthLimited = 1;
-    info.searchIsTimeLimited = 0;
-    info.depthLimit = depth;
-    info.terminateSearch = 0;
-
     start = getRealTime();
     
-    // Search each benchmark position
+    // Each worker takes the next unsearched position until none remain
+    for (i = 0; i < BenchThreads; i++)
+        pthread_create(&pthreads[i], NULL, &runBenchmarkWorker, &threads[i]);
+    
+    for (i = 0; i < BenchThreads; i++)
+        pthread_join(pthreads[i], NULL);
+    
+    elapsed = getRealTime() - start;
+    
     for (i = 0; i < NUM_BENCHMARKS; i++){
-        info.startTime = getRealTime();
-        initalizeBoard((&info.board), Benchmarks[i]);
-        clearTranspositionTable(&Table);
-        getBestMove(&info);
+        
+        moveToString(moveStr, BenchMoves[i]);
+        printf("Bench [# %2d] bestmove %-5s nodes %10"PRIu64" time %6dms nps %9d\n",
+               i + 1, moveStr, BenchNodes[i], (int)BenchTimes[i],
+               (int)(1000.0 * BenchNodes[i] / (1.0 + BenchTimes[i])));
+        
+        // Fold the node counts and moves into a single signature
+        nodes += BenchNodes[i];
+        signature = (signature ^ BenchNodes[i] ^ BenchMoves[i]) * 0x100000001B3ull;
+    }
+    
+    printf("\n");
+    printf("Threads   : %d\n", BenchThreads);
+    printf("Depth     : %d\n", BenchDepth);
+    printf("Time      : %dms\n", (int)elapsed);
+    printf("Nodes     : %"PRIu64"\n", nodes);
+    printf("NPS       : %d\n", (int)(1000.0 * nodes / (1.0 + elapsed)));
+    printf("Signature : %016"PRIx64"\n", signature);
+    fflush(stdout);
+    
+    // Statistics are only gathered in builds with -DSTATS
+    if (STATISTICS){
+        printf("\n");
+        printStatisticsJSON(&BenchStats);
     }
     
-    end = getRealTime();
+    for (i = 0; i < BenchThreads; i++)
+        destroyTranspositionTable(&tables[i]);
     
-    printf("Benchtime = %dms\n", (int)(end - start));    
+    free(threads);
+    free(tables);
+    free(pthreads);
+}
+
+/**
+ * Search benchmark positions until every position has been claimed.
+ * Used as the entry point for each of the threads of runBenchmark.
+ *
+ * @param   argument    Thread to perform the searches with
+ *
+ * @return              Always NULL
+ */
+void * runBenchmarkWorker(void * argument){
+    
+    int index;
+    double start;
+    uint16_t ponderMove;
+    
+    Thread * thread = (Thread *)argument;
+    
+    SearchInfo info;
+    info.searchIsInfinite = 0;
+    info.searchIsDepthLimited = 1;
+    info.searchIsTimeLimited = 0;
+    info.searchIsTimeManaged = 0;
+    info.searchIsNodeLimited = 0;
+    info.searchIsSilent = 1;
+    info.searchIsPondering = 0;
+    info.depthLimit = BenchDepth;
+    info.multiPV = 1;
+    info.searchMovesSize = 0;
+    
+    while (1){
+        
+        // Claim the next position which has not been searched
+        pthread_mutex_lock(&BenchLock);
+        index = BenchNext++;
+        pthread_mutex_unlock(&BenchLock);
+        
+        if (index >= NUM_BENCHMARKS)
+            return NULL;
+        
+        // Each position is searched as if it began a new game
+        clearTranspositionTable(thread->table);
+        clearHistory(thread->history);
+        clearContinuationHistory(thread->continuation);
+        clearCaptureHistory(thread->captureHistory);
+        
+        initalizeBoard(&info.board, Benchmarks[index]);
+        info.terminateSearch = 0;
+        info.startTime = start = getRealTime();
+        
+        BenchMoves[index] = getBestMove(thread, &info, &ponderMove);
+        BenchNodes[index] = thread->nodes;
+        BenchTimes[index] = getRealTime() - start;
+        
+        if (STATISTICS){
+            pthread_mutex_lock(&BenchLock);
+            mergeStatistics(&BenchStats, &thread->stats);
+            pthread_mutex_unlock(&BenchLock);
+        }
+    }
 }
\ No newline at end of file
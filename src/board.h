@@ -24,6 +24,9 @@
 void initalizeBoard(Board * board, char * fen);
 void printBoard(Board * board);
 uint64_t perft(Board * board, int depth);
-void runBenchmark(int depth);
+void runBenchmark(int depth, int nthreads);
+void * runBenchmarkWorker(void * argument);
+
+#define BENCH_DEPTH (10)
 
 #endif
\ No newline at end of file
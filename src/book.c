@@ -0,0 +1,250 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#if defined(_WIN32) || defined(_WIN64)
+    #include <stdio.h>
+#else
+    #define _POSIX_C_SOURCE 200112L
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "book.h"
+#include "castle.h"
+#include "move.h"
+#include "movegen.h"
+#include "types.h"
+#include "zorbist.h"
+
+Book OpeningBook;
+
+/**
+ * Open a Polyglot opening book. Where possible the file is mapped into
+ * memory rather than read, so that the operating system only loads the
+ * pages which are actually probed, and can share them between several
+ * running engines. Any previously opened book is closed first.
+ *
+ * @param   book    Book to open the file into
+ * @param   fname   Path to the Polyglot .bin file
+ *
+ * @return          1 if the book was opened, 0 otherwise
+ */
+int openBook(Book * book, char * fname){
+    
+    closeBook(book);
+    
+#if defined(_WIN32) || defined(_WIN64)
+    
+    long size;
+    FILE * fin = fopen(fname, "rb");
+    if (fin == NULL) return 0;
+    
+    fseek(fin, 0, SEEK_END);
+    size = ftell(fin);
+    fseek(fin, 0, SEEK_SET);
+    
+    if (size <= 0 || size % BOOK_ENTRY_SIZE){
+        fclose(fin);
+        return 0;
+    }
+    
+    book->data = malloc(size);
+    if (fread(book->data, 1, size, fin) != (size_t)size){
+        fclose(fin);
+        closeBook(book);
+        return 0;
+    }
+    
+    fclose(fin);
+    book->size = (uint64_t)size;
+    book->isMapped = 0;
+    
+#else
+    
+    struct stat info;
+    void * data;
+    int fd = open(fname, O_RDONLY);
+    if (fd == -1) return 0;
+    
+    if (fstat(fd, &info) == -1
+        || info.st_size <= 0
+        || info.st_size % BOOK_ENTRY_SIZE){
+        close(fd);
+        return 0;
+    }
+    
+    data = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) return 0;
+    
+    book->data = data;
+    book->size = (uint64_t)info.st_size;
+    book->isMapped = 1;
+    
+#endif
+    
+    book->entries = book->size / BOOK_ENTRY_SIZE;
+    book->seed = (uint64_t)time(NULL) | 1ull;
+    return 1;
+}
+
+/**
+ * Release the memory used by an opening book, if one is open.
+ *
+ * @param   book    Book to close
+ */
+void closeBook(Book * book){
+    
+    if (book->data != NULL){
+#if defined(_WIN32) || defined(_WIN64)
+        free(book->data);
+#else
+        if (book->isMapped) munmap(book->data, book->size);
+        else free(book->data);
+#endif
+    }
+    
+    book->data = NULL;
+    book->size = book->entries = 0ull;
+}
+
+/**
+ * Look for the Board in an opening book. Entries are sorted by key, so
+ * the first entry for the position is found with a binary search, and
+ * all of the following entries with the same key are candidates. Moves
+ * are then chosen at random in proportion to their weights, or the one
+ * with the highest weight is played when random selection is disabled.
+ *
+ * @param   book    Book to search for the position
+ * @param   board   Board to find a move for
+ * @param   random  Select among the book moves by their weights
+ *
+ * @return          Move from the book, or NONE_MOVE
+ */
+uint16_t probeBook(Book * book, Board * board, int random){
+    
+    int i, best, found = 0, size = 0;
+    uint64_t key, pick, total = 0ull, lower = 0ull, upper = book->entries, mid;
+    uint16_t moves[MAX_MOVES], candidates[MAX_MOVES], entryMove;
+    uint32_t weights[MAX_MOVES];
+    uint8_t * entry;
+    
+    if (book->data == NULL)
+        return NONE_MOVE;
+    
+    key = polyglotKey(board);
+    
+    // Find the first entry with a key not less than the Board's
+    while (lower < upper){
+        mid = lower + (upper - lower) / 2;
+        if (readBigEndian(book->data + mid * BOOK_ENTRY_SIZE, 8) < key)
+            lower = mid + 1;
+        else
+            upper = mid;
+    }
+    
+    genAllLegalMoves(board, moves, &size);
+    
+    // Collect each entry for this position which is a legal move
+    for (entry = book->data + lower * BOOK_ENTRY_SIZE;
+         entry < book->data + book->size && readBigEndian(entry, 8) == key;
+         entry += BOOK_ENTRY_SIZE){
+        
+        entryMove = (uint16_t)readBigEndian(entry + 8, 2);
+        
+        for (i = 0; i < size && found < MAX_MOVES; i++){
+            if (polyglotMove(moves[i]) == entryMove){
+                candidates[found] = moves[i];
+                weights[found] = (uint32_t)readBigEndian(entry + 10, 2);
+                total += weights[found++];
+                break;
+            }
+        }
+    }
+    
+    if (found == 0)
+        return NONE_MOVE;
+    
+    // Pick the move with the highest weight
+    if (!random || total == 0){
+        for (best = 0, i = 1; i < found; i++)
+            if (weights[i] > weights[best])
+                best = i;
+        return candidates[best];
+    }
+    
+    // Pick a random move in proportion to the weights
+    book->seed ^= book->seed >> 12;
+    book->seed ^= book->seed << 25;
+    book->seed ^= book->seed >> 27;
+    pick = (book->seed * 2685821657736338717ull) % total;
+    
+    for (i = 0; i < found - 1; i++){
+        if (pick < weights[i]) break;
+        pick -= weights[i];
+    }
+    
+    return candidates[i];
+}
+
+/**
+ * Convert a move to the encoding used by the Polyglot book format. The
+ * promotion piece uses one through four for knight through queen, and
+ * castling is encoded as the king capturing its own rook.
+ *
+ * @param   move    Move to convert
+ *
+ * @return          Polyglot encoding of the move
+ */
+uint16_t polyglotMove(uint16_t move){
+    
+    int from = MoveFrom(move), to = MoveTo(move), promo = 0;
+    
+    if (MoveType(move) == CASTLE_MOVE)
+        to = CastleGetRookFrom(from, to);
+    
+    if (MoveType(move) == PROMOTION_MOVE)
+        promo = 1 + (MovePromoType(move) >> 14);
+    
+    return (uint16_t)(to | (from << 6) | (promo << 12));
+}
+
+/**
+ * Read an unsigned big endian integer, as used by the Polyglot format.
+ *
+ * @param   bytes   Location of the integer
+ * @param   length  Number of bytes in the integer
+ *
+ * @return          Value of the integer
+ */
+uint64_t readBigEndian(uint8_t * bytes, int length){
+    
+    int i;
+    uint64_t value = 0ull;
+    
+    for (i = 0; i < length; i++)
+        value = (value << 8) | bytes[i];
+    
+    return value;
+}
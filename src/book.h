@@ -0,0 +1,42 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _BOOK_H
+#define _BOOK_H
+
+#include <stdint.h>
+
+#include "types.h"
+
+// Polyglot entries are a 64-bit key, a 16-bit move, a 16-bit weight
+// and a 32-bit learning value, stored big endian and sorted by key
+#define BOOK_ENTRY_SIZE (16)
+
+int openBook(Book * book, char * fname);
+
+void closeBook(Book * book);
+
+uint16_t probeBook(Book * book, Board * board, int random);
+
+uint16_t polyglotMove(uint16_t move);
+
+uint64_t readBigEndian(uint8_t * bytes, int length);
+
+extern Book OpeningBook;
+
+#endif
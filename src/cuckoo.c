@@ -0,0 +1,179 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "cuckoo.h"
+#include "magics.h"
+#include "move.h"
+#include "movegen.h"
+#include "piece.h"
+#include "types.h"
+#include "zorbist.h"
+
+uint64_t CuckooKeys[CUCKOO_SIZE];
+uint16_t CuckooMoves[CUCKOO_SIZE];
+
+/**
+ * Build the cuckoo tables used to spot upcoming repetitions. Every
+ * reversible move, which is any move by a piece other than a pawn, is
+ * stored by the change it makes to the hash of a board. Each key has
+ * two possible slots, and an insertion evicts the current occupant to
+ * its other slot, until an empty slot is found. Magics and Zorbist keys
+ * must be initalized first.
+ */
+void initalizeCuckoo(){
+    
+    int type, colour, piece, sq1, sq2, index;
+    uint64_t attacks, key, tempKey;
+    uint16_t move, tempMove;
+    
+    for (index = 0; index < CUCKOO_SIZE; index++){
+        CuckooKeys[index] = 0ull;
+        CuckooMoves[index] = NONE_MOVE;
+    }
+    
+    for (type = KNIGHT; type <= KING; type++){
+        for (colour = WHITE; colour <= BLACK; colour++){
+            
+            piece = MakePiece(type * 4, colour);
+            
+            for (sq1 = 0; sq1 < SQUARE_NB; sq1++){
+                
+                // Squares the piece could reach on an empty board
+                attacks = type == KNIGHT ? KnightAttacks(sq1, ~0ull)
+                        : type == BISHOP ? BishopAttacks(sq1, 0ull, ~0ull)
+                        : type == ROOK   ? RookAttacks(sq1, 0ull, ~0ull)
+                        : type == QUEEN  ? BishopAttacks(sq1, 0ull, ~0ull)
+                                         | RookAttacks(sq1, 0ull, ~0ull)
+                        :                  KingAttacks(sq1, ~0ull);
+                
+                // Each pair of squares is only stored once, as the
+                // move in either direction changes the hash equally
+                for (sq2 = sq1 + 1; sq2 < SQUARE_NB; sq2++){
+                    
+                    if (!(attacks & (1ull << sq2)))
+                        continue;
+                    
+                    key  = ZorbistKeys[piece][sq1];
+                    key ^= ZorbistKeys[piece][sq2];
+                    key ^= ZorbistKeys[TURN][0];
+                    move = MoveMake(sq1, sq2, NORMAL_MOVE);
+                    
+                    // Insert, evicting entries until one lands in an empty slot
+                    index = CuckooHash1(key);
+                    while (1){
+                        
+                        tempKey = CuckooKeys[index];
+                        tempMove = CuckooMoves[index];
+                        CuckooKeys[index] = key;
+                        CuckooMoves[index] = move;
+                        key = tempKey;
+                        move = tempMove;
+                        
+                        if (move == NONE_MOVE)
+                            break;
+                        
+                        index = index == CuckooHash1(key) ? CuckooHash2(key)
+                                                          : CuckooHash1(key);
+                    }
+                }
+            }
+        }
+    }
+}
+
+/**
+ * Determine if the side to move has a reversible move which returns the
+ * game to a position seen earlier in the search. Such a line is a draw
+ * by repetition, so the position is worth at least a draw, and this is
+ * known a ply before the repetition itself would be found. Positions
+ * before the root are not used, as they would need to have repeated.
+ *
+ * @param   board   Board to look for a cycle from
+ * @param   height  Distance from the root of the search
+ *
+ * @return          1 if a move would repeat a position, 0 otherwise
+ */
+int hasGameCycle(Board * board, int height){
+    
+    int i, index, end;
+    uint64_t key, occupied;
+    uint16_t move;
+    
+    // The position i plies back must be within the tree, and may not
+    // come before the last irreversible move or the last null move
+    end = board->fiftyMoveRule < board->pliesFromNull
+        ? board->fiftyMoveRule : board->pliesFromNull;
+    end = end < height ? end : height - 1;
+    if (end < 3) return 0;
+    
+    occupied = board->colours[WHITE] | board->colours[BLACK];
+    
+    for (i = 3; i <= end; i += 2){
+        
+        key = board->hash ^ board->history[board->numMoves - i];
+        
+        index = CuckooHash1(key);
+        if (CuckooKeys[index] != key){
+            index = CuckooHash2(key);
+            if (CuckooKeys[index] != key)
+                continue;
+        }
+        
+        // The move must not be blocked by any piece
+        move = CuckooMoves[index];
+        if (!(squaresBetween(MoveFrom(move), MoveTo(move)) & occupied))
+            return 1;
+    }
+    
+    return 0;
+}
+
+/**
+ * Compute the squares strictly between two squares on a shared rank,
+ * file or diagonal. Squares which are not aligned have none between.
+ *
+ * @param   sq1     First square
+ * @param   sq2     Second square
+ *
+ * @return          Bitboard of the squares between sq1 and sq2
+ */
+uint64_t squaresBetween(int sq1, int sq2){
+    
+    int rankStep, fileStep, rank, file;
+    int rankDelta = (sq2 / 8) - (sq1 / 8);
+    int fileDelta = (sq2 % 8) - (sq1 % 8);
+    uint64_t between = 0ull;
+    
+    if (   rankDelta != 0 && fileDelta != 0
+        && abs(rankDelta) != abs(fileDelta))
+        return 0ull;
+    
+    rankStep = (rankDelta > 0) - (rankDelta < 0);
+    fileStep = (fileDelta > 0) - (fileDelta < 0);
+    
+    rank = sq1 / 8 + rankStep;
+    file = sq1 % 8 + fileStep;
+    
+    for (; rank * 8 + file != sq2; rank += rankStep, file += fileStep)
+        between |= 1ull << (rank * 8 + file);
+    
+    return between;
+}
@@ -0,0 +1,38 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _CUCKOO_H
+#define _CUCKOO_H
+
+#include <stdint.h>
+
+#include "types.h"
+
+#define CUCKOO_SIZE (8192)
+
+#define CuckooHash1(key) ((int)((key) & (CUCKOO_SIZE - 1)))
+#define CuckooHash2(key) ((int)(((key) >> 16) & (CUCKOO_SIZE - 1)))
+
+void initalizeCuckoo();
+int hasGameCycle(Board * board, int height);
+uint64_t squaresBetween(int sq1, int sq2);
+
+extern uint64_t CuckooKeys[CUCKOO_SIZE];
+extern uint16_t CuckooMoves[CUCKOO_SIZE];
+
+#endif
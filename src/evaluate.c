@@ -21,6 +21,7 @@
 #include <string.h>
 #include <assert.h>
 
+#include "bitbase.h"
 #include "castle.h"
 #include "movegen.h"
 #include "magics.h"
@@ -32,6 +33,8 @@
 #include "evaluate.h"
 #include "piece.h"
 
+EvalTrace T, EmptyTrace;
+
 const int SafetyTable[100] = { // Taken from CPW / Stockfish
     0,  0,   1,   2,   3,   5,   7,   9,  12,  15,
   18,  22,  26,  30,  35,  39,  44,  50,  56,  62,
@@ -132,6 +135,31 @@ int evaluateBoard(Board * board, PawnTable * ptable){
     uint64_t queens  = board->pieces[QUEEN];
     uint64_t kings   = board->pieces[KING];
     
+    int result, eval;
+    
+    // KPK and KRK are known exactly. The tuner needs a linear
+    // evaluation, so the bitbases are skipped while tracing
+    if (!TRACE && (result = probeBitbases(board)) != BITBASE_UNKNOWN){
+        
+        if (result == BITBASE_DRAW)
+            return 0;
+        
+        // Keep the usual terms so the search still makes progress
+        eval = evaluatePieces(board, ptable);
+        return (board->colours[board->turn] & (pawns | rooks))
+             ? eval + KNOWN_WIN : eval - KNOWN_WIN;
+    }
+    
+    // A Queen or Rook against a lone King is just as surely won. Giving
+    // every such ending the bonus of the bitbases keeps the search from
+    // preferring one won ending over another, such as underpromoting
+    if (!TRACE && (queens | rooks) && (white == (white & kings) || black == (black & kings))){
+        
+        eval = evaluatePieces(board, ptable);
+        return (board->colours[board->turn] & (queens | rooks))
+             ? eval + KNOWN_WIN : eval - KNOWN_WIN;
+    }
+    
     // Check for recognized draws
     if ((pawns | rooks | queens) == 0ull){
         
@@ -220,6 +248,10 @@ int evaluatePieces(Board * board, PawnTable * ptable){
     
     PawnEntry * pentry = getPawnEntry(ptable, board->phash);
     
+    // When tracing the evaluation for the tuner we must
+    // always evaluate the pawns, to be able to record them
+    if (TRACE) pentry = NULL;
+    
     for (colour = BLACK; colour >= WHITE; colour--){
         
         // Negate the scores so that the scores are from
@@ -252,24 +284,28 @@ int evaluatePieces(Board * board, PawnTable * ptable){
         if (tempBishops && (myPawns & LEFT_WING) && (myPawns & RIGHT_WING)){
             mg += BishopHasWings[MG];
             eg += BishopHasWings[EG];
+            if (TRACE) T.BishopHasWings[colour]++;
         }
         
         // Bishop gains a bonus for being in a pair
         if ((tempBishops & WHITE_SQUARES) && (tempBishops & BLACK_SQUARES)){
             mg += BishopPair[MG];
             eg += BishopPair[EG];
+            if (TRACE) T.BishopPair[colour]++;
         }
         
         // King gains a bonus if it has castled since the root
         if (board->hasCastled[colour]){
             mg += KING_HAS_CASTLED;
             eg += KING_HAS_CASTLED;
+            if (TRACE) T.KingHasCastled[colour]++;
         }
         
         // King gains a bonus if it still may castle
         else if (board->castleRights & (3 << (2*colour))){
             mg += KING_CAN_CASTLE;
             eg += KING_CAN_CASTLE;
+            if (TRACE) T.KingCanCastle[colour]++;
         }
         
         // Get the attack board for the pawns
@@ -302,18 +338,21 @@ int evaluatePieces(Board * board, PawnTable * ptable){
             if (!(IsolatedPawnMasks[bit] & tempPawns)){
                 pawnmg -= PAWN_ISOLATED_MID;
                 pawneg -= PAWN_ISOLATED_END;
+                if (TRACE) T.PawnIsolated[colour]--;
             }
             
             // Apply a penalty if the pawn is stacked
             if (Files[File(bit)] & tempPawns){
                 pawnmg -= PAWN_STACKED_MID;
                 pawneg -= PAWN_STACKED_END;
+                if (TRACE) T.PawnStacked[colour]--;
             }
             
             // Apply a bonus if the pawn is connected
             if (PawnConnectedMasks[colour][bit] & myPawns){
                 pawnmg += PawnConnected[colour][bit];
                 pawneg += PawnConnected[colour][bit];
+                if (TRACE) T.PawnConnected[colour == WHITE ? bit : bit ^ 56][colour]++;
             }
             
         } AfterPawnLoop:
@@ -339,6 +378,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
                 
                 mg += KnightOutpostValues[MG][defended];
                 eg += KnightOutpostValues[EG][defended];
+                if (TRACE) T.KnightOutpostValues[defended][colour]++;
             }
             
             // Knight gains a mobility bonus based off of the number
@@ -346,6 +386,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
             mobiltyCount = popcount((mobilityArea & attacks));
             mg += KnightMobility[MG][mobiltyCount];
             eg += KnightMobility[EG][mobiltyCount];
+            if (TRACE) T.KnightMobility[mobiltyCount][colour]++;
             
             // Get the attack counts for this Knight
             attacks = attacks & kingAreas[!colour];
@@ -376,6 +417,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
                 
                 mg += BishopOutpostValues[MG][defended];
                 eg += BishopOutpostValues[EG][defended];
+                if (TRACE) T.BishopOutpostValues[defended][colour]++;
             }
             
             // Bishop gains a mobility bonus based off of the number
@@ -383,6 +425,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
             mobiltyCount = popcount((mobilityArea & attacks));
             mg += BishopMobility[MG][mobiltyCount];
             eg += BishopMobility[EG][mobiltyCount];
+            if (TRACE) T.BishopMobility[mobiltyCount][colour]++;
             
             // Get the attack counts for this Bishop
             attacks = attacks & kingAreas[!colour];
@@ -412,11 +455,13 @@ int evaluatePieces(Board * board, PawnTable * ptable){
                 if (!(enemyPawns & Files[File(bit)])){
                     mg += ROOK_OPEN_FILE_MID;
                     eg += ROOK_OPEN_FILE_END;
+                    if (TRACE) T.RookOpenFile[colour]++;
                 }
                 
                 else{
                     mg += ROOK_SEMI_FILE_MID;
                     eg += ROOK_SEMI_FILE_END;
+                    if (TRACE) T.RookSemiFile[colour]++;
                 }
             }
             
@@ -425,6 +470,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
             if (Rank(bit) == (colour == BLACK ? 1 : 6)){
                 mg += ROOK_ON_7TH_MID;
                 eg += ROOK_ON_7TH_END;
+                if (TRACE) T.RookOn7th[colour]++;
             }
             
             // Rook gains a mobility bonus based off of the number
@@ -432,6 +478,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
             mobiltyCount = popcount((mobilityArea & attacks));
             mg += RookMobility[MG][mobiltyCount];
             eg += RookMobility[EG][mobiltyCount];
+            if (TRACE) T.RookMobility[mobiltyCount][colour]++;
             
             // Get the attack counts for this Rook
             attacks = attacks & kingAreas[!colour];
@@ -459,6 +506,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
             mobiltyCount = popcount((mobilityArea & attacks));
             mg += QueenMobility[MG][mobiltyCount];
             eg += QueenMobility[EG][mobiltyCount];
+            if (TRACE) T.QueenMobility[mobiltyCount][colour]++;
             
             // Get the attack counts for this Queen
             attacks = attacks & kingAreas[!colour];
@@ -511,6 +559,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
             
             mg += PawnPassed[MG][canAdvance][safeAdvance][rank];
             eg += PawnPassed[EG][canAdvance][safeAdvance][rank];
+            if (TRACE) T.PawnPassed[canAdvance][safeAdvance][rank][colour]++;
         }
     }
 
@@ -536,6 +585,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
         
             mg -= SafetyTable[attackCounts[!colour]];
             eg -= SafetyTable[attackCounts[!colour]];
+            if (TRACE) T.SafetyTable[attackCounts[!colour]][colour]--;
         }
     }
     
@@ -544,6 +594,7 @@ int evaluatePieces(Board * board, PawnTable * ptable){
     
     mg += (board->turn == WHITE) ? Tempo[MG] : -Tempo[MG];
     eg += (board->turn == WHITE) ? Tempo[EG] : -Tempo[EG];
+    if (TRACE) T.Tempo[board->turn]++;
     
     curPhase = 24 - (popcount(knights | bishops))
                   - (popcount(rooks) << 1)
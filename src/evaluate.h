@@ -24,6 +24,12 @@
 int evaluateBoard(Board * board, PawnTable * ptable);
 int evaluatePieces(Board * board, PawnTable * ptable);
 
+#ifdef TUNE
+    #define TRACE   (1)
+#else
+    #define TRACE   (0)
+#endif
+
 #define MG          (0)
 #define EG          (1)
 
@@ -34,6 +40,8 @@ int evaluatePieces(Board * board, PawnTable * ptable);
 #define QueenValue  (1000)
 #define KingValue   ( 100)
 
+#define KNOWN_WIN   (1000)
+
 #define KING_HAS_CASTLED     (25)
 #define KING_CAN_CASTLE      (10)
 
@@ -52,8 +60,8 @@ int evaluatePieces(Board * board, PawnTable * ptable);
 extern const int PawnConnected[COLOUR_NB][SQUARE_NB];
 extern const int PawnPassed[PHASE_NB][2][2][RANK_NB];
 extern const int PieceValues[8];
-extern const int KnightOutpost[PHASE_NB][2];
-extern const int BishopOutpost[PHASE_NB][2];
+extern const int KnightOutpostValues[PHASE_NB][2];
+extern const int BishopOutpostValues[PHASE_NB][2];
 extern const int KnightMobility[PHASE_NB][9];
 extern const int BishopMobility[PHASE_NB][14];
 extern const int RookMobility[PHASE_NB][15];
@@ -63,4 +71,6 @@ extern const int BishopHasWings[PHASE_NB];
 extern const int BishopPair[PHASE_NB];
 extern const int Tempo[PHASE_NB];
 
+extern EvalTrace T, EmptyTrace;
+
 #endif
\ No newline at end of file
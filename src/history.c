@@ -16,52 +16,56 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <stdlib.h>
+#include <string.h>
+
 #include "board.h"
 #include "history.h"
 #include "move.h"
+#include "piece.h"
 #include "types.h"
 
 /**
- * Reset the History counters for a new search
+ * Reset the History counters for a new game
  *
  * @param   history HistoryTable struct to clear
  */
 void clearHistory(HistoryTable history){
     
-    int colour, from, to, counter;
+    memset(history, 0, sizeof(HistoryTable));
+}
+
+/**
+ * Age the History counters before a new search. Halving each entry keeps
+ * what was learned while searching the earlier moves of the game, while
+ * letting the new search quickly outweigh it.
+ *
+ * @param   history HistoryTable struct to decay
+ */
+void decayHistory(HistoryTable history){
+    
+    int i;
+    int16_t * entries = &history[0][0][0];
     
-    // Fill all History entries with ones. By using
-    // ones instead of zeros we avoid division by zero
-    for (colour = 0; colour < COLOUR_NB; colour++)
-        for (from = 0; from < SQUARE_NB; from++)
-            for (to = 0; to < SQUARE_NB; to++)
-                for (counter = 0; counter < 2; counter++)
-                    history[colour][from][to][counter] = 1;
+    for (i = 0; i < COLOUR_NB * SQUARE_NB * SQUARE_NB; i++)
+        entries[i] /= 2;
 }
 
 /**
- * Update the History of a particular move
+ * Update the History of a particular move. Each update moves the entry
+ * towards +-HISTORY_MAX, by less the closer it already is, so the entries
+ * saturate without ever needing to be rescaled.
  *
  * @param   history HistoryTable containing the move
  * @param   move    The move we are updating
  * @param   colour  Colour of player who made the move
- * @param   isGood  Whether or not the move was the best
- * @param   delta   Amount to increment by
+ * @param   delta   Amount to adjust by, negative for a bad move
  */
-void updateHistory(HistoryTable history, uint16_t move, int colour, int isGood,
-                                                                    int delta){
+void updateHistory(HistoryTable history, uint16_t move, int colour, int delta){
     
-    int from = MoveFrom(move);
-    int to = MoveTo(move);
+    int16_t * entry = &history[colour][MoveFrom(move)][MoveTo(move)];
     
-    if (isGood) history[colour][from][to][HISTORY_GOOD] += delta;
-    history[colour][from][to][HISTORY_TOTAL] += delta;
-    
-    // Divide counters by two if we have exceeded the max values
-    if (history[colour][from][to][HISTORY_TOTAL] >= HISTORY_MAX){
-        history[colour][from][to][HISTORY_GOOD] >>= 1;
-        history[colour][from][to][HISTORY_TOTAL] >>= 1;
-    }
+    *entry += delta - *entry * abs(delta) / HISTORY_MAX;
 }
 
 /**
@@ -70,16 +74,162 @@ void updateHistory(HistoryTable history, uint16_t move, int colour, int isGood,
  * @param   history HistoryTable containing the move
  * @param   move    The move we are updating
  * @param   colour  Colour of player who made the move
- * @param   factor  Maximum value of history score
+ *
+ * @return          History of the move, within +-HISTORY_MAX
+ */
+int getHistoryScore(HistoryTable history, uint16_t move, int colour){
+    
+    return history[colour][MoveFrom(move)][MoveTo(move)];
+}
+
+/**
+ * Reset the counter move and follow up move History for a new game
+ *
+ * @param   continuation    ContinuationTable to clear
+ */
+void clearContinuationHistory(ContinuationTable continuation){
+    
+    memset(continuation, 0, sizeof(ContinuationTable));
+}
+
+/**
+ * Age the counter move and follow up move History before a new search
+ *
+ * @param   continuation    ContinuationTable to decay
  */
-int getHistoryScore(HistoryTable history, uint16_t move, int colour,
-                                                        int factor){
+void decayContinuationHistory(ContinuationTable continuation){
+    
+    int i;
+    int16_t * entries = &continuation[0][0][0][0][0];
     
-    int from = MoveFrom(move);
+    for (i = 0; i < (int)(sizeof(ContinuationTable) / sizeof(int16_t)); i++)
+        entries[i] /= 2;
+}
+
+/**
+ * Update the counter move and follow up move History of a quiet move. These
+ * are indexed by the piece and destination of the moves played one and two
+ * plies earlier, which are found on the Thread's move stack. Entries move
+ * towards +-CONTINUATION_MAX, slowing down as they approach it.
+ *
+ * @param   thread  Thread holding the tables and the move stack
+ * @param   height  Height of the node the move was played from
+ * @param   move    The move we are updating
+ * @param   delta   Amount to adjust by, negative for a bad move
+ */
+void updateContinuationHistory(Thread * thread, int height, uint16_t move,
+                                                                 int delta){
+    
+    int i, previous;
+    int piece = PieceType(thread->info->board.squares[MoveFrom(move)]);
     int to = MoveTo(move);
+    int16_t * entry;
     
-    int good = history[colour][from][to][HISTORY_GOOD];
-    int total = history[colour][from][to][HISTORY_TOTAL];
+    for (i = 0; i < 2 && i < height; i++){
+        
+        previous = thread->moveStack[height-1-i];
+        if (previous == NONE_MOVE || previous == NULL_MOVE)
+            continue;
+        
+        entry = &thread->continuation[i][thread->pieceStack[height-1-i]]
+                                       [MoveTo(previous)][piece][to];
+        *entry += delta - *entry * abs(delta) / CONTINUATION_MAX;
+    }
+}
+
+/**
+ * Fetch the combined counter move and follow up move History of a move
+ *
+ * @param   thread  Thread holding the tables and the move stack
+ * @param   height  Height of the node the move is played from
+ * @param   move    The move we are scoring
+ *
+ * @return          Sum of both entries, within +-2*CONTINUATION_MAX
+ */
+int getContinuationScore(Thread * thread, int height, uint16_t move){
     
-    return (factor * good) / total;
-}
\ No newline at end of file
+    int i, piece, previous, score = 0;
+    int to = MoveTo(move);
+    
+    for (i = 0; i < 2 && i < height; i++){
+        
+        previous = thread->moveStack[height-1-i];
+        if (previous == NONE_MOVE || previous == NULL_MOVE)
+            continue;
+        
+        piece = PieceType(thread->info->board.squares[MoveFrom(move)]);
+        score += thread->continuation[i][thread->pieceStack[height-1-i]]
+                                        [MoveTo(previous)][piece][to];
+    }
+    
+    return score;
+}
+
+/**
+ * Reset the capture History for a new game
+ *
+ * @param   history CaptureHistoryTable to clear
+ */
+void clearCaptureHistory(CaptureHistoryTable history){
+    
+    memset(history, 0, sizeof(CaptureHistoryTable));
+}
+
+/**
+ * Age the capture History before a new search
+ *
+ * @param   history CaptureHistoryTable to decay
+ */
+void decayCaptureHistory(CaptureHistoryTable history){
+    
+    int i;
+    int16_t * entries = &history[0][0][0];
+    
+    for (i = 0; i < (int)(sizeof(CaptureHistoryTable) / sizeof(int16_t)); i++)
+        entries[i] /= 2;
+}
+
+/**
+ * Update the capture History of a noisy move, which is indexed by the moving
+ * piece, the destination, and the type of the captured piece. Promotions
+ * which do not capture use PIECE_NB as the captured type.
+ *
+ * @param   history CaptureHistoryTable containing the move
+ * @param   board   Board the move is played on
+ * @param   move    The move we are updating
+ * @param   delta   Amount to adjust by, negative for a bad move
+ */
+void updateCaptureHistory(CaptureHistoryTable history, Board * board,
+                                         uint16_t move, int delta){
+    
+    int to = MoveTo(move);
+    int piece = PieceType(board->squares[MoveFrom(move)]);
+    int captured = MoveType(move) == ENPASS_MOVE ? PAWN
+                 : board->squares[to] == EMPTY  ? PIECE_NB
+                 : PieceType(board->squares[to]);
+    
+    int16_t * entry = &history[piece][to][captured];
+    
+    *entry += delta - *entry * abs(delta) / CAPTURE_HISTORY_MAX;
+}
+
+/**
+ * Fetch the capture History of a noisy move
+ *
+ * @param   history CaptureHistoryTable containing the move
+ * @param   board   Board the move is played on
+ * @param   move    The move we are scoring
+ *
+ * @return          History of the move, within +-CAPTURE_HISTORY_MAX
+ */
+int getCaptureHistoryScore(CaptureHistoryTable history, Board * board,
+                                                      uint16_t move){
+    
+    int to = MoveTo(move);
+    int piece = PieceType(board->squares[MoveFrom(move)]);
+    int captured = MoveType(move) == ENPASS_MOVE ? PAWN
+                 : board->squares[to] == EMPTY  ? PIECE_NB
+                 : PieceType(board->squares[to]);
+    
+    return history[piece][to][captured];
+}
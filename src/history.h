@@ -19,17 +19,37 @@
 #ifndef _HISTORY_H
 #define _HISTORY_H
 
-#define HISTORY_GOOD    (0)
-#define HISTORY_TOTAL   (1)
+#define HISTORY_MAX      (0x4000)
 
-#define HISTORY_MAX     (0x7FFF)
+#define CONTINUATION_MAX (0x4000)
+
+#define CAPTURE_HISTORY_MAX (0x4000)
 
 void clearHistory(HistoryTable history);
 
-void updateHistory(HistoryTable history, uint16_t move, int colour, int isGood,
-                                                                    int delta);
+void decayHistory(HistoryTable history);
+
+void updateHistory(HistoryTable history, uint16_t move, int colour, int delta);
+
+int getHistoryScore(HistoryTable history, uint16_t move, int colour);
+
+void clearContinuationHistory(ContinuationTable continuation);
+
+void decayContinuationHistory(ContinuationTable continuation);
+
+void updateContinuationHistory(Thread * thread, int height, uint16_t move,
+                                                                 int delta);
+
+int getContinuationScore(Thread * thread, int height, uint16_t move);
+
+void clearCaptureHistory(CaptureHistoryTable history);
+
+void decayCaptureHistory(CaptureHistoryTable history);
+
+void updateCaptureHistory(CaptureHistoryTable history, Board * board,
+                                         uint16_t move, int delta);
 
-int getHistoryScore(HistoryTable history, uint16_t move, int colour,
-                                                        int factor);
+int getCaptureHistoryScore(CaptureHistoryTable history, Board * board,
+                                                      uint16_t move);
 
 #endif
\ No newline at end of file
@@ -66,12 +66,14 @@ void applyMove(Board * board, uint16_t move, Undo * undo){
     undo->turn = board->turn;
     undo->castleRights = board->castleRights;
     undo->fiftyMoveRule = board->fiftyMoveRule;
+    undo->pliesFromNull = board->pliesFromNull;
     undo->opening = board->opening;
     undo->endgame = board->endgame;
     undo->phash = board->phash;
     undo->hash = board->hash;
     
-    // Update the hash history and the move count
+    // Update the hash history, its filter, and the move count
+    board->repetitionFilter[board->hash & (REPETITION_FILTER_SIZE - 1)]++;
     board->history[board->numMoves++] = board->hash;
     
     // Update the key to include the turn change
@@ -80,6 +82,7 @@ void applyMove(Board * board, uint16_t move, Undo * undo){
     // Always increment the fifty counter
     // We will reset later if needed
     board->fiftyMoveRule += 1;
+    board->pliesFromNull += 1;
     
     if (MoveType(move) == NORMAL_MOVE){
         to = MoveTo(move);
@@ -385,11 +388,13 @@ void revertMove(Board * board, uint16_t move, Undo * undo){
     uint64_t shiftEnpass;
     
     board->numMoves--;
+    board->repetitionFilter[undo->hash & (REPETITION_FILTER_SIZE - 1)]--;
     
     board->turn = undo->turn;
     board->castleRights = undo->castleRights;
     board->epSquare = undo->epSquare;
     board->fiftyMoveRule = undo->fiftyMoveRule;
+    board->pliesFromNull = undo->pliesFromNull;
     board->opening = undo->opening;
     board->endgame = undo->endgame;
     board->phash = undo->phash;
@@ -506,10 +511,13 @@ void applyNullMove(Board * board, Undo * undo){
     undo->turn = board->turn;
     undo->hash = board->hash;
     undo->epSquare = board->epSquare;
+    undo->pliesFromNull = board->pliesFromNull;
     
-    // Swap the turn and update the history
+    // Swap the turn and update the history. No position before the
+    // null move may be repeated by the moves which follow it
     board->turn = !board->turn;
     board->history[board->numMoves++] = NULL_MOVE;
+    board->pliesFromNull = 0;
     
     // Update the key to include the turn change
     board->hash ^= ZorbistKeys[TURN][0];
@@ -533,6 +541,7 @@ void revertNullMove(Board * board, Undo * undo){
     board->turn = !board->turn;
     board->hash = undo->hash;
     board->epSquare = undo->epSquare;
+    board->pliesFromNull = undo->pliesFromNull;
     board->numMoves--;
     
 }
@@ -20,23 +20,34 @@
 #include <stdlib.h>
 
 #include "bitboards.h"
+#include "bitutils.h"
 #include "castle.h"
 #include "evaluate.h"
 #include "history.h"
 #include "move.h"
 #include "movegen.h"
 #include "movepicker.h"
+#include "masks.h"
 #include "piece.h"
 #include "psqt.h"
+#include "stats.h"
 #include "types.h"
 
-extern HistoryTable History;
+// Piece values used by the static exchange evaluation. The King is never
+// actually traded off, so its value does not matter to the exchange
+const int SEEPieceValues[8] = {PawnValue, KnightValue, BishopValue,
+                         RookValue, QueenValue, 0, 0, 0};
 
-void initalizeMovePicker(MovePicker * mp, int isQuiescencePick,
-                          uint16_t tableMove, uint16_t killer1,
-                                             uint16_t killer2){
+void initalizeMovePicker(MovePicker * mp, Thread * thread, int height,
+                   int isQuiescencePick, uint16_t tableMove,
+                         uint16_t killer1, uint16_t killer2){
                                  
+    mp->thread = thread;
+    mp->height = height;
     mp->isQuiescencePick = isQuiescencePick;
+    mp->skipQuiets = 0;
+    mp->skipBadNoisy = 0;
+    mp->threshold = 0;
     mp->stage = STAGE_TABLE;
     mp->split = 0;
     mp->noisySize = 0;
@@ -47,11 +58,28 @@ void initalizeMovePicker(MovePicker * mp, int isQuiescencePick,
     mp->killer2 = (killer2 != tableMove) ? killer2 : NONE_MOVE;
 }
 
+void initalizeNoisyMovePicker(MovePicker * mp, Thread * thread, int height,
+                                                            int threshold){
+    
+    initalizeMovePicker(mp, thread, height, 1, NONE_MOVE, NONE_MOVE, NONE_MOVE);
+    
+    // Only return the noisy moves which win at least the threshold
+    mp->stage = STAGE_GENERATE_NOISY;
+    mp->skipBadNoisy = 1;
+    mp->threshold = threshold;
+}
+
 uint16_t selectNextMove(MovePicker * mp, Board * board){
     
-    int i, best;
+    int i, best, value;
     uint16_t bestMove;
     
+    // The search has asked us to stop returning quiet moves. Jump ahead
+    // to the noisy moves which failed the static exchange evaluation
+    if (   mp->skipQuiets
+        && mp->stage > STAGE_GOOD_NOISY
+        && mp->stage < STAGE_BAD_NOISY)
+        mp->stage = STAGE_BAD_NOISY;
     
     switch (mp->stage){
         
@@ -61,8 +89,10 @@ uint16_t selectNextMove(MovePicker * mp, Board * board){
             mp->stage = STAGE_GENERATE_NOISY;
             
             // See if the table move is an available move
-            if (moveIsPsuedoLegal(board, mp->tableMove))
-                return mp->tableMove;            
+            if (moveIsPsuedoLegal(board, mp->tableMove)){
+                if (STATISTICS) mp->thread->stats.pickedTable++;
+                return mp->tableMove;
+            }            
         
         
         case STAGE_GENERATE_NOISY:
@@ -76,46 +106,69 @@ uint16_t selectNextMove(MovePicker * mp, Board * board){
             mp->split = mp->noisySize;
             
             // This stage is only a helper, advance to move selection
-            mp->stage = STAGE_NOISY ;
+            mp->stage = STAGE_GOOD_NOISY;
             
         
-        case STAGE_NOISY:
+        case STAGE_GOOD_NOISY:
         
-            // Check to see if there are still noisy moves left
-            if (mp->noisySize != 0){
+            // Moves in [0, badSize) have failed the static exchange
+            // evaluation, while moves in [badSize, noisySize) are untried
+            while (mp->noisySize > mp->badSize){
         
                 // Find highest scoring move
-                for (best = 0, i = 1; i < mp->noisySize; i++)
+                for (best = mp->badSize, i = best + 1; i < mp->noisySize; i++)
                     if (mp->values[i] > mp->values[best])
                         best = i;
-                    
+                
                 // Save the best move before overwriting it
                 bestMove = mp->moves[best];
                 
+                // Don't play the table move twice
+                if (bestMove == mp->tableMove){
+                    mp->noisySize -= 1;
+                    mp->moves[best] = mp->moves[mp->noisySize];
+                    mp->values[best] = mp->values[mp->noisySize];
+                    continue;
+                }
+                
+                // Moves which lose material are delayed until after the
+                // quiet moves, by swapping them into the bad section
+                if (!staticExchangeEvaluation(board, bestMove, mp->threshold)){
+                    value = mp->values[best];
+                    mp->moves[best] = mp->moves[mp->badSize];
+                    mp->values[best] = mp->values[mp->badSize];
+                    mp->moves[mp->badSize] = bestMove;
+                    mp->values[mp->badSize] = value;
+                    mp->badSize += 1;
+                    
+                    // Don't play the killer moves twice
+                    if (bestMove == mp->killer1) mp->killer1 = NONE_MOVE;
+                    if (bestMove == mp->killer2) mp->killer2 = NONE_MOVE;
+                    continue;
+                }
+                
                 // Reduce effective move list size
                 mp->noisySize -= 1;
                 mp->moves[best] = mp->moves[mp->noisySize];
                 mp->values[best] = mp->values[mp->noisySize];
                 
-                // Don't play the table move twice
-                if (bestMove == mp->tableMove)
-                    return selectNextMove(mp, board);
-                
                 // Don't play the killer moves twice
                 if (bestMove == mp->killer1) mp->killer1 = NONE_MOVE;
                 if (bestMove == mp->killer2) mp->killer2 = NONE_MOVE;
                 
+                if (STATISTICS) mp->thread->stats.pickedNoisy++;
                 return bestMove;
             }
             
-            // If no noisy moves, or no good ones left, advance stages
+            // If no good noisy moves are left, advance stages
             mp->stage = STAGE_KILLER_1;
             
             // If we are using this move picker for the quiescence
-            // search, we have exhausted all moves already
-            if (mp->isQuiescencePick){
-                mp->stage = STAGE_DONE;
-                return NONE_MOVE;
+            // search, or have been told to skip the quiet moves,
+            // go straight to the bad noisy moves
+            if (mp->isQuiescencePick || mp->skipQuiets){
+                mp->stage = STAGE_BAD_NOISY;
+                return selectNextMove(mp, board);
             }
             
             
@@ -124,8 +177,10 @@ uint16_t selectNextMove(MovePicker * mp, Board * board){
             // Advance to the next stage no matter what
             mp->stage = STAGE_KILLER_2;
             
-            if (moveIsPsuedoLegal(board, mp->killer1))
+            if (moveIsPsuedoLegal(board, mp->killer1)){
+                if (STATISTICS) mp->thread->stats.pickedKiller++;
                 return mp->killer1;
+            }
             
             
         case STAGE_KILLER_2:
@@ -133,8 +188,10 @@ uint16_t selectNextMove(MovePicker * mp, Board * board){
             // Advance to the next stage no matter what
             mp->stage = STAGE_GENERATE_QUIET;
             
-            if (moveIsPsuedoLegal(board, mp->killer2))
+            if (moveIsPsuedoLegal(board, mp->killer2)){
+                if (STATISTICS) mp->thread->stats.pickedKiller++;
                 return mp->killer2;
+            }
         
         
         case STAGE_GENERATE_QUIET:
@@ -172,10 +229,38 @@ uint16_t selectNextMove(MovePicker * mp, Board * board){
                     || bestMove == mp->killer2)
                     return selectNextMove(mp, board);
                 
+                if (STATISTICS) mp->thread->stats.pickedQuiet++;
                 return bestMove;
             }
             
             // If no quiet moves left, advance stages
+            mp->stage = STAGE_BAD_NOISY;
+            
+            
+        case STAGE_BAD_NOISY:
+        
+            // Check to see if there are still bad noisy moves left, which
+            // some pickers have no use for
+            if (mp->badSize != 0 && !mp->skipBadNoisy){
+                
+                // Find highest scoring move
+                for (best = 0, i = 1; i < mp->badSize; i++)
+                    if (mp->values[i] > mp->values[best])
+                        best = i;
+                
+                // Save the best move before overwriting it
+                bestMove = mp->moves[best];
+                
+                // Reduce effective move list size
+                mp->badSize -= 1;
+                mp->moves[best] = mp->moves[mp->badSize];
+                mp->values[best] = mp->values[mp->badSize];
+                
+                if (STATISTICS) mp->thread->stats.pickedNoisy++;
+                return bestMove;
+            }
+            
+            // If no bad noisy moves left, advance stages
             mp->stage = STAGE_DONE;
             
             
@@ -217,6 +302,10 @@ void evaluateNoisyMoves(MovePicker * mp, Board * board){
         else if (MoveType(move) == ENPASS_MOVE)
             value = PawnValue - PAWN;
         
+        // Refine the order by how the capture has fared so far,
+        // which is worth at most about a pawn in either direction
+        value += getCaptureHistoryScore(mp->thread->captureHistory, board, move) / 128;
+        
         mp->values[i] = value;
     }
 }
@@ -232,14 +321,26 @@ void evaluateQuietMoves(MovePicker * mp, Board * board){
         from = MoveFrom(move);
         to = MoveTo(move);
         
-        // Use the history score and PSQT to evaluate the move
-        value =  getHistoryScore(History, move, board->turn, 512);
+        // Use the history scores and PSQT to evaluate the move. The history
+        // score is within +-512, and the counter and follow up move scores
+        // together within +-1024. Values are plain ints, so none can overflow
+        value =  getHistoryScore(mp->thread->history, move, board->turn) / 32;
+        value += getContinuationScore(mp->thread, mp->height, move) / 32;
         value += abs(PSQTopening[board->squares[from]][to]);
         value -= abs(PSQTopening[board->squares[from]][from]);
         mp->values[i] = value;
     }
 }
 
+int moveIsQuiet(Board * board, uint16_t move){
+    
+    if (MoveType(move) == CASTLE_MOVE)
+        return 1;
+    
+    return MoveType(move) == NORMAL_MOVE
+        && board->squares[MoveTo(move)] == EMPTY;
+}
+
 int moveIsGoodCapture(Board * board, uint16_t move){
     
     int from, to, fromType, toType;
@@ -259,6 +360,110 @@ int moveIsGoodCapture(Board * board, uint16_t move){
     return PieceValues[toType] >= PieceValues[fromType];    
 }
 
+int staticExchangeEvaluation(Board * board, uint16_t move, int threshold){
+    
+    int from, to, type, colour, balance, nextVictim;
+    uint64_t bishops, rooks, occupied, attackers, myAttackers;
+    
+    // Unpack move information
+    from = MoveFrom(move);
+    to = MoveTo(move);
+    type = MoveType(move);
+    
+    // Castling moves can never lose material
+    if (type == CASTLE_MOVE)
+        return 0 >= threshold;
+    
+    // Next victim is the moving piece, or the piece it promotes to
+    nextVictim = type != PROMOTION_MOVE
+               ? PieceType(board->squares[from])
+               : 1 + (MovePromoType(move) >> 14);
+    
+    // Balance is the value of the move minus the threshold. Enpass
+    // moves capture a Pawn, which is not on the destination square
+    balance = type == ENPASS_MOVE ? SEEPieceValues[PAWN]
+            : SEEPieceValues[PieceType(board->squares[to])];
+    
+    if (type == PROMOTION_MOVE)
+        balance += SEEPieceValues[nextVictim] - SEEPieceValues[PAWN];
+    
+    balance -= threshold;
+    
+    // Even winning the piece for free would not meet the threshold
+    if (balance < 0) return 0;
+    
+    // Losing the moved piece would still meet the threshold
+    balance -= SEEPieceValues[nextVictim];
+    if (balance >= 0) return 1;
+    
+    // Sliders, which may be revealed as pieces leave the board
+    bishops = board->pieces[BISHOP] | board->pieces[QUEEN];
+    rooks   = board->pieces[ROOK  ] | board->pieces[QUEEN];
+    
+    // Occupancy after the move, including the removal of an Enpass capture
+    occupied = board->colours[WHITE] | board->colours[BLACK];
+    occupied = (occupied ^ (1ull << from)) | (1ull << to);
+    if (type == ENPASS_MOVE) occupied ^= 1ull << (to ^ 8);
+    
+    // Every piece of either colour which attacks the destination
+    attackers = (PawnAttackMasks[WHITE][to] & board->colours[WHITE] & board->pieces[PAWN])
+              | (PawnAttackMasks[BLACK][to] & board->colours[BLACK] & board->pieces[PAWN])
+              | KnightAttacks(to, board->pieces[KNIGHT])
+              | BishopAttacks(to, occupied, bishops)
+              | RookAttacks(to, occupied, rooks)
+              | KingAttacks(to, board->pieces[KING]);
+    attackers &= occupied;
+    
+    // The opponent makes the next capture
+    colour = !board->turn;
+    
+    while (1){
+        
+        // If we have no more attackers left we lose
+        myAttackers = attackers & board->colours[colour];
+        if (myAttackers == 0ull) break;
+        
+        // Find our weakest piece to attack with
+        for (nextVictim = PAWN; nextVictim <= QUEEN; nextVictim++)
+            if (myAttackers & board->pieces[nextVictim])
+                break;
+        
+        // Remove this attacker from the occupied squares
+        occupied ^= 1ull << getLSB(myAttackers & board->pieces[nextVictim]);
+        
+        // A diagonal move may reveal bishop or queen attackers
+        if (nextVictim == PAWN || nextVictim == BISHOP || nextVictim == QUEEN)
+            attackers |= BishopAttacks(to, occupied, bishops);
+        
+        // A vertical or horizontal move may reveal rook or queen attackers
+        if (nextVictim == ROOK || nextVictim == QUEEN)
+            attackers |= RookAttacks(to, occupied, rooks);
+        
+        // Make sure we did not add any already used attacks
+        attackers &= occupied;
+        
+        // Swap the turn
+        colour = !colour;
+        
+        // Negamax the balance and add the value of the next victim
+        balance = -balance - 1 - SEEPieceValues[nextVictim];
+        
+        // We win if the balance holds even after giving away our piece
+        if (balance >= 0){
+            
+            // A King may not capture onto a square which is still
+            // attacked, so in that case the exchange goes the other way
+            if (nextVictim == KING && (attackers & board->colours[colour]))
+                colour = !colour;
+            
+            break;
+        }
+    }
+    
+    // Side to move after the loop loses
+    return board->turn != colour;
+}
+
 int moveIsPsuedoLegal(Board * board, uint16_t move){
     
     int from, to, moveType, promoType, fromType; 
@@ -21,16 +21,20 @@
 
 #define STAGE_TABLE             (0)
 #define STAGE_GENERATE_NOISY    (1)
-#define STAGE_NOISY             (2)
+#define STAGE_GOOD_NOISY        (2)
 #define STAGE_KILLER_1          (3)
 #define STAGE_KILLER_2          (4)
 #define STAGE_GENERATE_QUIET    (5)
 #define STAGE_QUIET             (6)
-#define STAGE_DONE              (7)
+#define STAGE_BAD_NOISY         (7)
+#define STAGE_DONE              (8)
 
-void initalizeMovePicker(MovePicker * mp, int isQuiescencePick,
-                          uint16_t tableMove, uint16_t killer1,
-                                             uint16_t killer2);
+void initalizeMovePicker(MovePicker * mp, Thread * thread, int height,
+                   int isQuiescencePick, uint16_t tableMove,
+                         uint16_t killer1, uint16_t killer2);
+
+void initalizeNoisyMovePicker(MovePicker * mp, Thread * thread, int height,
+                                                            int threshold);
 
 uint16_t selectNextMove(MovePicker * mp, Board * board);
 
@@ -38,8 +42,12 @@ void evaluateNoisyMoves(MovePicker * mp, Board * board);
 
 void evaluateQuietMoves(MovePicker * mp, Board * board);
 
+int moveIsQuiet(Board * board, uint16_t move);
+
 int moveIsGoodCapture(Board * board, uint16_t move);
 
+int staticExchangeEvaluation(Board * board, uint16_t move, int threshold);
+
 int moveIsPsuedoLegal(Board * board, uint16_t move);
 
 #endif
\ No newline at end of file
@@ -18,6 +18,8 @@
 
 #include <assert.h>
 #include <inttypes.h>
+#include <math.h>
+#include <pthread.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -27,27 +29,47 @@
 #include "bitboards.h"
 #include "board.h"
 #include "castle.h"
+#include "cuckoo.h"
 #include "evaluate.h"
 #include "history.h"
 #include "piece.h"
 #include "psqt.h"
 #include "search.h"
+#include "stats.h"
+#include "syzygy.h"
 #include "transposition.h"
 #include "types.h"
-#include "time.h"
+#include "timer.h"
+#include "timeman.h"
+#include "uci.h"
 #include "move.h"
 #include "movegen.h"
 #include "movepicker.h"
 
-uint64_t TotalNodes;
-int EvaluatingPlayer;
-SearchInfo * Info;
-HistoryTable History;
-
 TransTable Table;
-PawnTable PTable;
 
-uint16_t KillerMoves[MAX_HEIGHT][2];
+// Late move reductions, indexed by the depth and by the move count
+int LMRTable[64][64];
+
+// Number of quiet moves tried before the rest are pruned, indexed by
+// whether the static eval is improving and by the remaining depth
+const int LateMovePruningCounts[2][LATE_MOVE_PRUNING_DEPTH + 1] = {
+    { 0,  3,  4,  6, 10, 15, 21, 28, 36},
+    { 0,  5,  6,  9, 15, 23, 32, 42, 54},
+};
+
+/**
+ * Fill the table of late move reductions. Reductions grow with the
+ * product of the logarithms of the depth and of the move count.
+ */
+void initalizeSearch(){
+    
+    int depth, played;
+    
+    for (depth = 1; depth < 64; depth++)
+        for (played = 1; played < 64; played++)
+            LMRTable[depth][played] = 0.75 + log(depth) * log(played) / 2.25;
+}
 
 /**
  * Determine the best move for the current position. Information about
@@ -55,95 +77,199 @@ uint16_t KillerMoves[MAX_HEIGHT][2];
  * in the info parameter. We will continue searching deeper and deeper
  * until one of our terminatiation conditions becomes true.
  *
- * @param   info    Information about the Board and the search parameters
+ * @param   thread      Thread which will perform the search
+ * @param   info        Information about the Board and the search parameters
+ * @param   ponderMove  Set to the expected reply to the best move, if any
  *
- * @return          The best move we can come up with
+ * @return              The best move we can come up with
  */
-uint16_t getBestMove(SearchInfo * info){
+uint16_t getBestMove(Thread * thread, SearchInfo * info, uint16_t * ponderMove){
     
-    int i, depth, elapsed, hashfull, value = 0;
+    int i, j, size, depth, multiPV, stop, values[MAX_MULTI_PV] = {0};
+    int value, moveValue;
+    uint16_t move;
+    PVariation line, lines[MAX_MULTI_PV];
     
-    // Create the main Principle Variation
-    PVariation pv;
-    pv.length = 0;
+    *ponderMove = NONE_MOVE;
     
-    // Initialize search globals
-    TotalNodes = 0ull;
-    EvaluatingPlayer = info->board.turn;
-    Info = info;
+    // Initialize the thread for this search
+    thread->info = info;
+    thread->nodes = 0ull;
+    thread->tbhits = 0ull;
+    thread->nextTimeCheck = TIME_CHECK_NODES;
+    clearStatistics(&thread->stats);
+    thread->evaluatingPlayer = info->board.turn;
+    memset(thread->killers, 0, sizeof(thread->killers));
+    thread->pvs[0].length = 0;
     
     // Prepare the transposition tables
-    updateTranspositionTable(&Table);
-    initalizePawnTable(&PTable);
-    clearHistory(History);
+    updateTranspositionTable(thread->table);
+    initalizePawnTable(&thread->ptable);
+    decayHistory(thread->history);
+    decayContinuationHistory(thread->continuation);
+    decayCaptureHistory(thread->captureHistory);
     
     // Populate the root's moves
     MoveList rootMoves;
     rootMoves.size = 0;
     genAllLegalMoves(&info->board, rootMoves.moves, &rootMoves.size);
     
+    // Only consider the moves given by go searchmoves, if any. Otherwise,
+    // only consider the moves which preserve the tablebase result
+    if (info->searchMovesSize){
+        for (size = 0, i = 0; i < rootMoves.size; i++)
+            for (j = 0; j < info->searchMovesSize; j++)
+                if (rootMoves.moves[i] == info->searchMoves[j])
+                    rootMoves.moves[size++] = rootMoves.moves[i];
+        rootMoves.size = size;
+    }
+    
+    else if (USE_SYZYGY)
+        probeSyzygyRoot(&info->board, &rootMoves);
+    
+    // Always have a move to play, even if the first iteration is cut short
+    rootMoves.bestMove = rootMoves.size ? rootMoves.moves[0] : NONE_MOVE;
+    
+    // We can not report more lines than there are moves
+    multiPV = info->multiPV < rootMoves.size ? info->multiPV : rootMoves.size;
+    
     // Perform interative deepening
     for (depth = 1; depth < MAX_DEPTH; depth++){
         
-        // Perform full search on Root
-        value = aspirationWindow(&pv, &info->board, &rootMoves, depth, value);
+        thread->depth = depth;
+        
+        // Search each line in turn. Lines which have already been found
+        // sit at the front of the move list, and are excluded from the
+        // root search of every line after them
+        for (thread->pvIndex = 0; thread->pvIndex < multiPV; thread->pvIndex++){
+            
+            i = thread->pvIndex;
+            values[i] = aspirationWindow(thread, &rootMoves, depth, values[i]);
+            
+            if (info->terminateSearch) break;
+            
+            lines[i] = thread->pvs[0];
+        }
         
         // Don't print a partial search
         if (info->terminateSearch) break;
         
-        elapsed = (int)(getRealTime() - info->startTime);
-        hashfull = (1000 * Table.used) / (Table.numBuckets * BUCKET_SIZE);
-        
-        printf("info depth %d ", depth);
-        printf("score cp %d ", value);
-        printf("time %d ", elapsed);
-        printf("nodes %"PRIu64" ", TotalNodes);
-        printf("nps %d ", (int)(1000 * (TotalNodes / (1 + elapsed))));
-        printf("hashfull %d ", hashfull);
-        printf("pv ");
-        
-        // Print the Principle Variation
-        for (i = 0; i < pv.length; i++){
-            printMove(pv.line[i]);
-            printf(" ");
+        // A later line may have found a better value than an earlier one.
+        // Stably sort the lines, keeping each with its root move, so that
+        // they are reported in order and the best line decides the move
+        for (i = 1; i < multiPV; i++){
+            
+            value = values[i];
+            line = lines[i];
+            move = rootMoves.moves[i];
+            moveValue = rootMoves.values[i];
+            
+            for (j = i; j > 0 && values[j-1] < value; j--){
+                values[j] = values[j-1];
+                lines[j] = lines[j-1];
+                rootMoves.moves[j] = rootMoves.moves[j-1];
+                rootMoves.values[j] = rootMoves.values[j-1];
+            }
+            
+            values[j] = value;
+            lines[j] = line;
+            rootMoves.moves[j] = move;
+            rootMoves.values[j] = moveValue;
         }
         
-        printf("\n");
-        fflush(stdout);
+        // Play the move of the best line, expecting its reply
+        if (multiPV && lines[0].length >= 1)
+            rootMoves.bestMove = lines[0].line[0];
+        
+        *ponderMove = multiPV && lines[0].length >= 2 ? lines[0].line[1] : NONE_MOVE;
+        
+        // Benchmarks do not report each iteration
+        if (!info->searchIsSilent)
+            for (i = 0; i < multiPV; i++)
+                printSearchInformation(thread, &lines[i], depth, values[i], i + 1);
         
         // Check for depth based termination
         if (info->searchIsDepthLimited && info->depthLimit == depth)
             break;
-            
-        // Check for time based termination 
-        if (info->searchIsTimeLimited){
-            if (getRealTime() > info->endTime2) break;
-            if (getRealTime() > info->endTime1) break;
-        }
+        
+        // The deadlines may be moved by a ponderhit at any moment
+        pthread_mutex_lock(&SearchLock);
+        
+        // Give more or less time depending on how the search is going
+        if (info->searchIsTimeManaged)
+            updateTimeManagement(info, depth, rootMoves.bestMove, values[0]);
+        
+        // Check for time based termination. The clock does not
+        // start until the opponent plays the move we ponder on
+        stop =   info->searchIsTimeLimited
+             && !info->searchIsPondering
+             && (   getRealTime() > info->endTime2
+                 || getRealTime() > info->endTime1
+                 || (info->searchIsTimeManaged && !timeForNextIteration(info)));
+        
+        pthread_mutex_unlock(&SearchLock);
+        
+        if (stop) break;
     }
     
     // Free the Pawn Table
-    destoryPawnTable(&PTable);
+    destoryPawnTable(&thread->ptable);
     
     return rootMoves.bestMove;
 }
 
+/**
+ * Report one line of a completed iteration to the GUI, following the
+ * format of the info command in the Universal Chess Interface.
+ *
+ * @param   thread  Thread which performed the search
+ * @param   pv      Principle Variation of the line
+ * @param   depth   Depth of the completed iteration
+ * @param   value   Value of the line
+ * @param   multiPV Rank of the line, starting from one
+ */
+void printSearchInformation(Thread * thread, PVariation * pv, int depth,
+                                                  int value, int multiPV){
+    
+    int i;
+    int elapsed = (int)(getRealTime() - thread->info->startTime);
+    int hashfull = (1000 * thread->table->used) / (thread->table->numBuckets * BUCKET_SIZE);
+    
+    printf("info depth %d ", depth);
+    printf("multipv %d ", multiPV);
+    printf("score cp %d ", value);
+    printf("time %d ", elapsed);
+    printf("nodes %"PRIu64" ", thread->nodes);
+    printf("nps %d ", (int)(1000 * (thread->nodes / (1 + elapsed))));
+    printf("hashfull %d ", hashfull);
+    if (USE_SYZYGY) printf("tbhits %"PRIu64" ", thread->tbhits);
+    printf("pv ");
+    
+    // Print the Principle Variation
+    for (i = 0; i < pv->length; i++){
+        printMove(pv->line[i]);
+        printf(" ");
+    }
+    
+    printf("\n");
+    fflush(stdout);
+}
+
 /**
  * Wrap the calls to rootSearch within a series of updating apsiration windows.
  * Current window margins of [30, 60, 120, 240] are quite arbitrary. Extensive
  * testing could likely find a better initial window and window updates. If no
  * window returns a valid score, we are forced to do a full windowed search.
  * 
- * @param   pv          Main principle variation line
- * @param   board       Board that we are searching on
+ * @param   thread      Thread performing the search
  * @param   moveList    List of moves from the root of the search
  * @param   depth       Depth of this particular search
  * @param   lastScore   Score from the previous depth
  *
  * @return              Value of the search
  */
-int aspirationWindow(PVariation * pv, Board * board, MoveList * moveList, 
-                                               int depth, int lastScore){
+int aspirationWindow(Thread * thread, MoveList * moveList, int depth,
+                                                          int lastScore){
     
     int alpha, beta, value, margin;
     
@@ -160,7 +286,7 @@ int aspirationWindow(PVariation * pv, Board * board, MoveList * moveList,
             beta  = lastScore + margin;
             
             // Perform the search on the modified window
-            value = rootSearch(pv, board, moveList, alpha, beta, depth);
+            value = rootSearch(thread, moveList, alpha, beta, depth);
             
             // Result was within our window
             if (value > alpha && value < beta)
@@ -173,41 +299,50 @@ int aspirationWindow(PVariation * pv, Board * board, MoveList * moveList,
     }
     
     // No searches scored within our aspiration windows, search full window
-    return rootSearch(pv, board, moveList, -MATE, MATE, depth);
+    return rootSearch(thread, moveList, -MATE, MATE, depth);
 }
 
 
-int rootSearch(PVariation * pv, Board * board, MoveList * moveList, int alpha,
-                                                         int beta, int depth){
+int rootSearch(Thread * thread, MoveList * moveList, int alpha, int beta,
+                                                              int depth){
+    
+    Board * board = &thread->info->board;
     
     Undo undo[1];
     uint64_t currentNodes;
     int i, value, best = -MATE;
     
-    // Zero out the root and local principle variations
+    // The root's line and the line of its children
+    PVariation * pv = &thread->pvs[0];
+    PVariation * lpv = &thread->pvs[1];
     pv->length = 0;
-    PVariation lpv;
-    lpv.length = 0;
+    
+    // Nodes two plies down compare their eval against the root's
+    thread->evalStack[0] = !isNotInCheck(board, board->turn) ? VALUE_NONE
+                         : evaluateBoard(board, &thread->ptable);
    
-    // Search through each move in the root's legal move list
-    for (i = 0; i < moveList->size; i++){
+    // Search through each move in the root's legal move list,
+    // skipping over the moves which begin an earlier MultiPV line
+    for (i = thread->pvIndex; i < moveList->size; i++){
         
-        currentNodes = TotalNodes;
+        currentNodes = thread->nodes;
         
-        // Apply the current move to the board
+        // Apply the current move to the board, noting it on the move stack
+        thread->moveStack[0] = moveList->moves[i];
+        thread->pieceStack[0] = PieceType(board->squares[MoveFrom(moveList->moves[i])]);
         applyMove(board, moveList->moves[i], undo);
         
         // Full window search for the first move
-        if (i == 0)
-            value = -alphaBetaSearch(&lpv, board, -beta, -alpha, depth-1, 1, PVNODE);
+        if (i == thread->pvIndex)
+            value = -alphaBetaSearch(thread, -beta, -alpha, depth-1, 1, PVNODE);
         
         // Null window search on all other moves
         else{
-            value = -alphaBetaSearch(&lpv, board, -alpha-1, -alpha, depth-1, 1, CUTNODE);
+            value = -alphaBetaSearch(thread, -alpha-1, -alpha, depth-1, 1, CUTNODE);
             
             // Null window failed high, we must search on a full window
             if (value > alpha)
-                value = -alphaBetaSearch(&lpv, board, -beta, -alpha, depth-1, 1, PVNODE);
+                value = -alphaBetaSearch(thread, -beta, -alpha, depth-1, 1, PVNODE);
         }
         
         // Revert the board state
@@ -215,7 +350,7 @@ int rootSearch(PVariation * pv, Board * board, MoveList * moveList, int alpha,
         
         
         if (value <= alpha)
-            moveList->values[i] = -(1<<28) + (int)(TotalNodes - currentNodes); // UPPER VALUE
+            moveList->values[i] = -(1<<28) + (int)(thread->nodes - currentNodes); // UPPER VALUE
         else if (value >= beta)
             moveList->values[i] = beta;  // LOWER VALUE
         else
@@ -225,16 +360,19 @@ int rootSearch(PVariation * pv, Board * board, MoveList * moveList, int alpha,
         // Improved current value
         if (value > best){
             best = value;
-            moveList->bestMove = moveList->moves[i];
+            
+            // Only the first line decides the move to be played
+            if (thread->pvIndex == 0)
+                moveList->bestMove = moveList->moves[i];
             
             // IMPROVED CURRENT LOWER VALUE
             if (value > alpha){
                 alpha = value;
                 
                 // Update the Principle Variation
-                pv->length = 1 + lpv.length;
+                pv->length = 1 + lpv->length;
                 pv->line[0] = moveList->moves[i];
-                memcpy(pv->line + 1, lpv.line, sizeof(uint16_t) * lpv.length);
+                memcpy(pv->line + 1, lpv->line, sizeof(uint16_t) * lpv->length);
             }
         }
         
@@ -244,44 +382,77 @@ int rootSearch(PVariation * pv, Board * board, MoveList * moveList, int alpha,
     }
     
     // SORT MOVELIST FOR NEXT ITERATION
-    sortMoveList(moveList);
+    sortMoveList(moveList, thread->pvIndex);
     return best;
 }
 
-int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta, 
-                                   int depth, int height, int nodeType){
+int alphaBetaSearch(Thread * thread, int alpha, int beta, int depth,
+                                              int height, int nodeType){
+    
+    Board * board = &thread->info->board;
     
     int i, value, newDepth, entryValue, entryType;
-    int min, max, inCheck;
-    int valid = 0, avoidedQS = 0, eval = 0;
-    int oldAlpha = alpha, best = -MATE, optimalValue = -MATE;
+    int min, max, inCheck, singularBeta = -MATE;
+    int valid = 0, avoidedQS = 0, eval = 0, extension;
+    int isQuiet, improving, quietsTried = 0, rBeta, R, hist = 0;
+    int oldAlpha = alpha, best = -MATE, optimalValue = -MATE, maxValue = MATE;
     
     uint16_t currentMove, tableMove = NONE_MOVE, bestMove = NONE_MOVE;
     uint16_t killer1, killer2, played[MAX_MOVES];
+    uint16_t excludedMove = thread->excludedMoves[height];
+    
+    uint64_t hash;
     
     MovePicker movePicker;
     
     TransEntry * entry;
     Undo undo[1];
     
-    PVariation lpv;
-    lpv.length = 0;
+    // This node's line is built from the line of its children
+    PVariation * pv = &thread->pvs[height];
+    PVariation * lpv = &thread->pvs[height+1];
     pv->length = 0;
     
-    // Check to see if search time has expired
-    if (Info->searchIsTimeLimited && getRealTime() >= Info->endTime2){
-        Info->terminateSearch = 1;
-        return board->turn == EvaluatingPlayer ? -MATE : MATE;
+    // Check to see if search time has expired. Reading the clock is
+    // a system call, so it is only done once every TIME_CHECK_NODES.
+    // The first iteration always completes, so that we have a move
+    if (   thread->info->searchIsTimeLimited
+        && !thread->info->searchIsPondering
+        &&  thread->depth > 1
+        &&  thread->nodes >= thread->nextTimeCheck){
+        thread->nextTimeCheck = thread->nodes + TIME_CHECK_NODES;
+        
+        // The deadline may be moved by a ponderhit at any moment
+        pthread_mutex_lock(&SearchLock);
+        if (getRealTime() >= thread->info->endTime2)
+            thread->info->terminateSearch = 1;
+        pthread_mutex_unlock(&SearchLock);
     }
     
+    // Check to see if the node budget has been spent
+    if (   thread->info->searchIsNodeLimited
+        && thread->nodes >= thread->info->nodeLimit)
+        thread->info->terminateSearch = 1;
+    
+    // Unwind the search once it has been terminated
+    if (thread->info->terminateSearch)
+        return board->turn == thread->evaluatingPlayer ? -MATE : MATE;
+    
     // Check for the fifty move rule
     if (board->fiftyMoveRule > 100)
         return 0;
     
-    // Check for three-fold repitition
-    for (i = board->numMoves-2; i >= 0; i-=2)
-        if (board->history[i] == board->hash)
-            return 0;
+    // Check for a draw by repitition
+    if (isRepetition(board, height))
+        return 0;
+    
+    // Check for a move which would repeat a position. Such a node is
+    // worth at least a draw, which may be enough for a cutoff already
+    if (USE_CUCKOO_CYCLES && alpha < 0 && hasGameCycle(board, height)){
+        alpha = oldAlpha = 0;
+        if (alpha >= beta)
+            return alpha;
+    }
     
     // SEARCH HORIZON REACHED, QSEARCH
     if (depth <= 0){
@@ -296,17 +467,26 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
         }
 
         else
-            return quiescenceSearch(board, alpha, beta, height);
+            return quiescenceSearch(thread, alpha, beta, height);
     }
     
     // INCREMENT TOTAL NODE COUNTER
-    TotalNodes++;
+    thread->nodes++;
+    if (STATISTICS) thread->stats.searchNodes++;
+    
+    // Searches which exclude a move are stored under their own key, so
+    // their results never pollute the entries of the full search
+    hash = excludedMove == NONE_MOVE ? board->hash
+         : ExcludedMoveHash(board->hash, excludedMove);
     
     // LOOKUP CURRENT POSITION IN TRANSPOSITION TABLE
-    entry = getTranspositionEntry(&Table, board->hash);
+    entry = getTranspositionEntry(thread->table, hash);
+    if (STATISTICS) thread->stats.tableProbes++;
     
     if (entry != NULL){
         
+        if (STATISTICS) thread->stats.tableHits++;
+        
         // ENTRY MOVE MAY BE CANDIDATE
         tableMove = EntryMove(*entry);
         
@@ -322,8 +502,10 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
             max = beta;
             
             // EXACT VALUE STORED
-            if (entryType == PVNODE)
+            if (entryType == PVNODE){
+                if (STATISTICS) thread->stats.tableCutoffs++;
                 return entryValue;
+            }
             
             // LOWER BOUND STORED
             else if (entryType == CUTNODE)
@@ -334,48 +516,151 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
                 max = entryValue < beta ? entryValue : beta;
             
             // BOUNDS NOW OVERLAP?
-            if (min >= max)
+            if (min >= max){
+                if (STATISTICS) thread->stats.tableCutoffs++;
                 return entryValue;
+            }
+        }
+    }
+    
+    // PROBE THE SYZYGY TABLEBASES. Singular searches are skipped, since
+    // the probe knows nothing of the excluded move
+    if (   USE_SYZYGY
+        && excludedMove == NONE_MOVE
+        && probeSyzygyWDL(board, height, &value)){
+        
+        thread->tbhits++;
+        
+        // WINS ARE LOWER BOUNDS AND LOSSES ARE UPPER BOUNDS
+        entryType = value > 0 ? CUTNODE : value < 0 ? ALLNODE : PVNODE;
+        
+        // Return when the bound alone decides the node
+        if (    entryType == PVNODE
+            || (entryType == CUTNODE && value >= beta)
+            || (entryType == ALLNODE && value <= alpha)){
+            
+            storeTranspositionEntry(thread->table, MAX_DEPTH-1, entryType, value, NONE_MOVE, hash);
+            return value;
+        }
+        
+        // Otherwise search on, with the bound limiting the final value
+        if (entryType == CUTNODE){
+            best = value;
+            alpha = MAX(alpha, value);
         }
+        
+        else maxValue = value;
     }
     
     // DETERMINE CHECK STATUS
     if (!avoidedQS)
         inCheck = !isNotInCheck(board, board->turn);
     
-    if (nodeType != PVNODE)
-        eval = evaluateBoard(board, &PTable);
+    // Evaluate the position, and note the eval so that we may tell whether
+    // the position improved for us since our previous move. The eval is
+    // meaningless when in check, so none is kept for such positions, and
+    // escaping a check from two plies ago is taken as an improvement
+    eval = thread->evalStack[height] = inCheck ? VALUE_NONE
+         : evaluateBoard(board, &thread->ptable);
+    
+    improving =  !inCheck
+              &&  height >= 2
+              && (   thread->evalStack[height-2] == VALUE_NONE
+                  || eval > thread->evalStack[height-2]);
+    
+    // RAZORING. When the eval is far below alpha at a shallow depth, only
+    // a tactic can save the position, which the quiescence search verifies
+    if (USE_RAZORING
+        && depth <= RAZOR_DEPTH
+        && nodeType != PVNODE
+        && excludedMove == NONE_MOVE
+        && !inCheck
+        && eval + RAZOR_MARGIN * depth <= alpha){
+        
+        value = quiescenceSearch(thread, alpha, alpha+1, height);
+        
+        if (value <= alpha){
+            if (STATISTICS) thread->stats.razorPrunes++;
+            return value;
+        }
+    }
     
-    // STATIC NULL MOVE PRUNING
+    // STATIC NULL MOVE PRUNING. The margin is one ply smaller when the
+    // eval is improving, since the position is then more likely to hold
     if (USE_STATIC_NULL_PRUNING
-        && depth <= 3
+        && depth <= STATIC_NULL_PRUNING_DEPTH
         && nodeType != PVNODE
+        && excludedMove == NONE_MOVE
         && !inCheck){
             
-        value = eval - (depth * (PawnValue + 15));
+        value = eval - (depth - improving) * STATIC_NULL_PRUNING_MARGIN;
         
-        if (value > beta)
+        if (value > beta){
+            if (STATISTICS) thread->stats.staticNullPrunes++;
             return value;
+        }
     }
     
     // NULL MOVE PRUNING
     if (USE_NULL_MOVE_PRUNING
         && depth >= 2
         && nodeType != PVNODE
+        && excludedMove == NONE_MOVE
         && canDoNull(board)
         && !inCheck
         && board->history[board->numMoves-1] != NULL_MOVE
         && eval >= beta){
             
+        thread->moveStack[height] = NULL_MOVE;
         applyNullMove(board, undo);
+        if (STATISTICS) thread->stats.nullMoveTries++;
         
         // PERFORM NULL MOVE SEARCH
-        value = -alphaBetaSearch(&lpv, board, -beta, -beta+1, depth-4, height+1, CUTNODE);
+        value = -alphaBetaSearch(thread, -beta, -beta+1, depth-4, height+1, CUTNODE);
         
         revertNullMove(board, undo);
         
-        if (value >= beta)
+        if (value >= beta){
+            if (STATISTICS) thread->stats.nullMoveCutoffs++;
             return value;
+        }
+    }
+    
+    // PROBCUT. A good capture which beats beta by a margin at a reduced
+    // depth is very likely to produce a cutoff at the full depth as well
+    if (USE_PROBCUT
+        && depth >= PROBCUT_DEPTH
+        && nodeType != PVNODE
+        && excludedMove == NONE_MOVE
+        && !inCheck
+        && abs(beta) < MATE - MAX_HEIGHT){
+        
+        rBeta = MIN(beta + PROBCUT_MARGIN, MATE - MAX_HEIGHT - 1);
+        
+        // Only try captures which win enough material to reach rBeta
+        initalizeNoisyMovePicker(&movePicker, thread, height, rBeta - eval);
+        
+        while ((currentMove = selectNextMove(&movePicker, board)) != NONE_MOVE){
+            
+            thread->moveStack[height] = currentMove;
+            thread->pieceStack[height] = PieceType(board->squares[MoveFrom(currentMove)]);
+            
+            applyMove(board, currentMove, undo);
+            if (!isNotInCheck(board, !board->turn)){
+                revertMove(board, currentMove, undo);
+                continue;
+            }
+            
+            if (STATISTICS) thread->stats.probCutTries++;
+            value = -alphaBetaSearch(thread, -rBeta, -rBeta+1, depth-4, height+1, CUTNODE);
+            
+            revertMove(board, currentMove, undo);
+            
+            if (value >= rBeta){
+                if (STATISTICS) thread->stats.probCutCutoffs++;
+                return value;
+            }
+        }
     }
     
     // INTERNAL ITERATIVE DEEPING
@@ -385,26 +670,83 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
         && nodeType == PVNODE){
         
         // SEARCH AT A LOWER DEPTH
-        value = alphaBetaSearch(&lpv, board, alpha, beta, depth-2, height, nodeType);
+        value = alphaBetaSearch(thread, alpha, beta, depth-2, height, nodeType);
         if (value <= alpha)
-            value = alphaBetaSearch(&lpv, board, -MATE, beta, depth-2, height, PVNODE);
+            value = alphaBetaSearch(thread, -MATE, beta, depth-2, height, PVNODE);
         
         // GET TABLE MOVE FROM TRANSPOSITION TABLE
-        entry = getTranspositionEntry(&Table, board->hash);
+        entry = getTranspositionEntry(thread->table, hash);
         if (entry != NULL)
             tableMove = entry->bestMove;
+        
+        // DISCARD THE LINE LEFT BY THE SHALLOWER SEARCH
+        pv->length = 0;
     }
     
     // CHECK EXTENSION
     depth += (!avoidedQS && inCheck && (nodeType == PVNODE || depth <= 6));
     
+    // A table move which failed high at a depth close to our own is a
+    // candidate for a singular extension. Note the bound it must clear
+    if (USE_SINGULAR_EXTENSIONS
+        && depth >= 8
+        && excludedMove == NONE_MOVE
+        && tableMove != NONE_MOVE
+        && (entry = getTranspositionEntry(thread->table, hash)) != NULL
+        && EntryMove(*entry) == tableMove
+        && EntryType(*entry) != ALLNODE
+        && EntryDepth(*entry) >= depth - 3
+        && abs(EntryValue(*entry)) < MATE / 2)
+        singularBeta = EntryValue(*entry) - 2 * depth;
+    
     // Setup the Move Picker
-    killer1 = KillerMoves[height][0];
-    killer2 = KillerMoves[height][1];
-    initalizeMovePicker(&movePicker, 0, tableMove, killer1, killer2);
+    killer1 = thread->killers[height][0];
+    killer2 = thread->killers[height][1];
+    initalizeMovePicker(&movePicker, thread, height, 0, tableMove, killer1, killer2);
     
     while((currentMove = selectNextMove(&movePicker, board)) != NONE_MOVE){
         
+        // SKIP THE MOVE BEING TESTED FOR SINGULARITY
+        if (currentMove == excludedMove)
+            continue;
+        
+        isQuiet = moveIsQuiet(board, currentMove);
+        
+        // History of a quiet move, which guides both pruning and reductions
+        if (isQuiet)
+            hist =  getHistoryScore(thread->history, currentMove, board->turn)
+                  + getContinuationScore(thread, height, currentMove);
+        
+        // LATE MOVE PRUNING. Once enough quiet moves have been tried at a
+        // low depth the rest are unlikely to matter, and the move picker
+        // is told that it need not even generate them
+        if (USE_LATE_MOVE_PRUNING
+            && nodeType != PVNODE
+            && isQuiet
+            && depth <= LATE_MOVE_PRUNING_DEPTH
+            && !inCheck
+            && best > -MATE + MAX_HEIGHT
+            && quietsTried >= LateMovePruningCounts[improving][depth]){
+            
+            if (STATISTICS) thread->stats.lateMovePrunes++;
+            movePicker.skipQuiets = 1;
+            continue;
+        }
+        
+        // HISTORY PRUNING. Skip quiet moves which have consistently
+        // failed to produce cutoffs in similar positions
+        if (USE_HISTORY_PRUNING
+            && nodeType != PVNODE
+            && isQuiet
+            && depth <= HISTORY_PRUNING_DEPTH
+            && !inCheck
+            && best > -MATE + MAX_HEIGHT
+            && hist < -HISTORY_PRUNING_MARGIN * depth * depth){
+            
+            if (STATISTICS) thread->stats.historyPrunes++;
+            continue;
+        }
+        
         // USE FUTILITY PRUNING
         if (USE_FUTILITY_PRUNING
             && nodeType != PVNODE
@@ -419,10 +761,38 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
             
             value = optimalValue;
             
-            if (value <= alpha)
+            if (value <= alpha){
+                if (STATISTICS) thread->stats.futilityPrunes++;
                 continue;
+            }
+        }
+        
+        // SINGULAR EXTENSION. Search every other move at a reduced depth
+        // against a bound below the table value. When all of them fail
+        // low, the table move is singular and is searched one ply deeper
+        extension = 0;
+        if (   currentMove == tableMove
+            && singularBeta != -MATE){
+            
+            if (STATISTICS) thread->stats.singularSearches++;
+            
+            thread->excludedMoves[height] = currentMove;
+            value = alphaBetaSearch(thread, singularBeta-1, singularBeta, depth/2, height, CUTNODE);
+            thread->excludedMoves[height] = NONE_MOVE;
+            
+            // The excluded search may have reused the line of this node
+            pv->length = 0;
+            
+            if (value < singularBeta){
+                if (STATISTICS) thread->stats.singularExtensions++;
+                extension = 1;
+            }
         }
         
+        // NOTE THE MOVE ON THE MOVE STACK FOR THE CHILDREN
+        thread->moveStack[height] = currentMove;
+        thread->pieceStack[height] = PieceType(board->squares[MoveFrom(currentMove)]);
+        
         // APPLY AND VALIDATE MOVE BEFORE SEARCHING
         applyMove(board, currentMove, undo);
         if (!isNotInCheck(board, !board->turn)){
@@ -432,43 +802,59 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
         
         // STORE MOVE IN PLAYED
         played[valid] = currentMove;
+        quietsTried += isQuiet;
     
         // INCREMENT COUNTER OF VALID MOVES FOUND
         valid++;
         
-        // DETERMINE IF WE CAN USE LATE MOVE REDUCTIONS
+        // Depth of the search before any reduction is applied
+        newDepth = depth - 1 + extension;
+        
+        // LATE MOVE REDUCTIONS. Quiet moves searched late are reduced by an
+        // amount from the table, reduced less in PV nodes, when the eval is
+        // improving, for killers, and for moves with a good history
         if (USE_LATE_MOVE_REDUCTIONS
-            && valid >= 5
+            && valid >= 2
             && depth >= 3
-            && getHistoryScore(History, currentMove, !board->turn, 100) < 80
+            && isQuiet
             && !inCheck
-            && MoveType(currentMove) == NORMAL_MOVE
-            && undo[0].capturePiece == EMPTY
-            && isNotInCheck(board, board->turn))
-            newDepth = depth - 2 - (valid >= 12) - (nodeType != PVNODE);
-        else
-            newDepth = depth-1;
+            && isNotInCheck(board, board->turn)){
+            
+            R  = LMRTable[MIN(depth, 63)][MIN(valid, 63)];
+            R += (nodeType != PVNODE);
+            R += !improving;
+            R -= (currentMove == killer1 || currentMove == killer2);
+            R -= hist / LMR_HISTORY_DIVISOR;
+            
+            // Reduce by at least one ply, but never past the horizon
+            R = MIN(depth - 1, MAX(R, 1));
+            
+            if (STATISTICS) thread->stats.reducedSearches++;
+        }
+        
+        else R = 0;
          
         // FULL WINDOW SEARCH ON FIRST MOVE
         if (valid == 1 || nodeType != PVNODE){
             
-            value = -alphaBetaSearch(&lpv, board, -beta, -alpha, newDepth, height+1, nodeType);
+            value = -alphaBetaSearch(thread, -beta, -alpha, newDepth-R, height+1, nodeType);
             
             // IMPROVED BOUND, BUT WAS REDUCED DEPTH?
-            if (value > alpha
-                && newDepth != depth-1){
-                    
-                value = -alphaBetaSearch(&lpv, board, -beta, -alpha, depth-1, height+1, nodeType);
+            if (value > alpha && R != 0){
+                if (STATISTICS) thread->stats.reducedResearches++;
+                value = -alphaBetaSearch(thread, -beta, -alpha, newDepth, height+1, nodeType);
             }
         }
         
         // NULL WINDOW SEARCH ON NON-FIRST / PV MOVES
         else{
-            value = -alphaBetaSearch(&lpv, board, -alpha-1, -alpha, newDepth, height+1, CUTNODE);
+            value = -alphaBetaSearch(thread, -alpha-1, -alpha, newDepth-R, height+1, CUTNODE);
             
             // NULL WINDOW FAILED HIGH, RESEARCH
-            if (value > alpha)
-                value = -alphaBetaSearch(&lpv, board, -beta, -alpha, depth-1, height+1, PVNODE);
+            if (value > alpha){
+                if (STATISTICS) thread->stats.nullWindowResearches++;
+                value = -alphaBetaSearch(thread, -beta, -alpha, newDepth, height+1, PVNODE);
+            }
         }
         
         // REVERT MOVE FROM BOARD
@@ -484,21 +870,24 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
                 alpha = value;
                 
                 // Update the Principle Variation
-                pv->length = 1 + lpv.length;
+                pv->length = 1 + lpv->length;
                 pv->line[0] = currentMove;
-                memcpy(pv->line + 1, lpv.line, sizeof(uint16_t) * lpv.length);
+                memcpy(pv->line + 1, lpv->line, sizeof(uint16_t) * lpv->length);
             }
         }
         
         // IMPROVED AND FAILED HIGH
         if (alpha >= beta){
             
+            if (STATISTICS) thread->stats.failHighs++;
+            if (STATISTICS && valid == 1) thread->stats.failHighsFirst++;
+            
             // UPDATE KILLER MOVES
             if (MoveType(currentMove) == NORMAL_MOVE
                 && undo[0].capturePiece == EMPTY
-                && KillerMoves[height][1] != currentMove){
-                KillerMoves[height][1] = KillerMoves[height][0];
-                KillerMoves[height][0] = currentMove;
+                && thread->killers[height][1] != currentMove){
+                thread->killers[height][1] = thread->killers[height][0];
+                thread->killers[height][0] = currentMove;
             }
             
             goto Cut;
@@ -508,6 +897,10 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
     // BOARD IS STALEMATE OR CHECKMATE
     if (valid == 0){
         
+        // ONLY THE EXCLUDED MOVE WAS LEGAL, WHICH IS TRIVIALLY SINGULAR
+        if (excludedMove != NONE_MOVE)
+            return alpha;
+        
         // BOARD IS STALEMATE
         if (isNotInCheck(board, board->turn))
             return 0;
@@ -519,42 +912,88 @@ int alphaBetaSearch(PVariation * pv, Board * board, int alpha, int beta,
     
     Cut:
     
-    if (best >= beta && bestMove != NONE_MOVE)
-        updateHistory(History, bestMove, board->turn, 1, depth*depth);
+    // A tablebase loss caps the value of the node
+    best = MIN(best, maxValue);
+    
+    // Only quiet moves are kept in the History. A quiet move which caused
+    // a cutoff is rewarded, while the quiet moves before it are punished
+    if (best >= beta && moveIsQuiet(board, bestMove))
+        updateHistory(thread->history, bestMove, board->turn, depth*depth);
     
     for (i = valid - 2; i >= 0; i--)
-        updateHistory(History, played[i], board->turn, 0, depth*depth);
+        if (moveIsQuiet(board, played[i]))
+            updateHistory(thread->history, played[i], board->turn, -depth*depth);
+    
+    // Quiet moves which caused a cutoff are rewarded in the continuation
+    // History, while the quiet moves searched before them are punished
+    if (best >= beta && moveIsQuiet(board, bestMove)){
+        
+        updateContinuationHistory(thread, height, bestMove, depth*depth);
+        
+        for (i = valid - 2; i >= 0; i--)
+            if (moveIsQuiet(board, played[i]))
+                updateContinuationHistory(thread, height, played[i], -depth*depth);
+    }
+    
+    // Likewise for the capture History of noisy moves. Every noisy move
+    // searched before the cutoff failed to produce it, and is punished
+    if (best >= beta){
+        
+        if (!moveIsQuiet(board, bestMove))
+            updateCaptureHistory(thread->captureHistory, board, bestMove, depth*depth);
+        
+        for (i = valid - 2; i >= 0; i--)
+            if (!moveIsQuiet(board, played[i]))
+                updateCaptureHistory(thread->captureHistory, board, played[i], -depth*depth);
+    }
     
     
     // STORE RESULTS IN TRANSPOSITION TABLE
-    if (!Info->searchIsTimeLimited || getRealTime() < Info->endTime2){
+    if (!thread->info->terminateSearch){
         if (best > oldAlpha && best < beta)
-            storeTranspositionEntry(&Table, depth,  PVNODE, best, bestMove, board->hash);
+            storeTranspositionEntry(thread->table, depth,  PVNODE, best, bestMove, hash);
         else if (best >= beta)
-            storeTranspositionEntry(&Table, depth, CUTNODE, best, bestMove, board->hash);
+            storeTranspositionEntry(thread->table, depth, CUTNODE, best, bestMove, hash);
         else if (best <= oldAlpha)
-            storeTranspositionEntry(&Table, depth, ALLNODE, best, bestMove, board->hash);
+            storeTranspositionEntry(thread->table, depth, ALLNODE, best, bestMove, hash);
     }
     
     return best;
 }
 
-int quiescenceSearch(Board * board, int alpha, int beta, int height){
+int quiescenceSearch(Thread * thread, int alpha, int beta, int height){
+    
+    Board * board = &thread->info->board;
     
     int eval, value, best, maxValueGain;
     uint16_t currentMove;
     Undo undo[1];
     MovePicker movePicker;
     
+    // This node's line is built from the line of its children
+    PVariation * pv = &thread->pvs[height];
+    PVariation * lpv = &thread->pvs[height+1];
+    pv->length = 0;
+    
     // MAX HEIGHT REACHED, STOP HERE
     if (height >= MAX_HEIGHT)
-        return evaluateBoard(board, &PTable);
+        return evaluateBoard(board, &thread->ptable);
+    
+    // Check to see if the node budget has been spent
+    if (   thread->info->searchIsNodeLimited
+        && thread->nodes >= thread->info->nodeLimit)
+        thread->info->terminateSearch = 1;
+    
+    // Unwind the search once it has been terminated
+    if (thread->info->terminateSearch)
+        return board->turn == thread->evaluatingPlayer ? -MATE : MATE;
     
     // INCREMENT TOTAL NODE COUNTER
-    TotalNodes++;
+    thread->nodes++;
+    if (STATISTICS) thread->stats.qsearchNodes++;
     
     // GET A STANDING-EVAL OF THE CURRENT BOARD
-    eval = evaluateBoard(board, &PTable);
+    eval = evaluateBoard(board, &thread->ptable);
     value = eval;
     
     // UPDATE LOWER BOUND
@@ -575,13 +1014,15 @@ int quiescenceSearch(Board * board, int alpha, int beta, int height){
     if (value + maxValueGain < alpha
         && popcount(board->colours[0] | board->colours[1]) >= 6
         && !(board->colours[0] & board->pieces[0] & RANK_7)
-        && !(board->colours[1] & board->pieces[0] & RANK_2))
+        && !(board->colours[1] & board->pieces[0] & RANK_2)){
+        if (STATISTICS) thread->stats.deltaPrunes++;
         return value;
+    }
     
     
     best = value;
     
-    initalizeMovePicker(&movePicker, 1, NONE_MOVE, NONE_MOVE, NONE_MOVE);
+    initalizeMovePicker(&movePicker, thread, height, 1, NONE_MOVE, NONE_MOVE, NONE_MOVE);
     
     while ((currentMove = selectNextMove(&movePicker, board)) != NONE_MOVE){
         
@@ -590,8 +1031,10 @@ int quiescenceSearch(Board * board, int alpha, int beta, int height){
         if (MoveType(currentMove) == PROMOTION_MOVE)
             value += PieceValues[PieceType(1 + (MovePromoType(currentMove) >> 14))];
         
-        if (value < alpha)
+        if (value < alpha){
+            if (STATISTICS) thread->stats.deltaPrunes++;
             continue;
+        }
         
         // APPLY AND VALIDATE MOVE BEFORE SEARCHING
         applyMove(board, currentMove, undo);
@@ -601,7 +1044,7 @@ int quiescenceSearch(Board * board, int alpha, int beta, int height){
         }
         
         // SEARCH NEXT DEPTH
-        value = -quiescenceSearch(board, -beta, -alpha, height+1);
+        value = -quiescenceSearch(thread, -beta, -alpha, height+1);
         
         // REVERT MOVE FROM BOARD
         revertMove(board, currentMove, undo);
@@ -611,8 +1054,14 @@ int quiescenceSearch(Board * board, int alpha, int beta, int height){
             best = value;
             
             // IMPROVED CURRENT LOWER VALUE
-            if (value > alpha)
+            if (value > alpha){
                 alpha = value;
+                
+                // Update the Principle Variation
+                pv->length = 1 + lpv->length;
+                pv->line[0] = currentMove;
+                memcpy(pv->line + 1, lpv->line, sizeof(uint16_t) * lpv->length);
+            }
         }
         
         // IMPROVED AND FAILED HIGH
@@ -623,79 +1072,11 @@ int quiescenceSearch(Board * board, int alpha, int beta, int height){
     return best;
 }
 
-void evaluateMoves(Board * board, int * values, uint16_t * moves, int size, int height, uint16_t tableMove){
-    
-    int i, value;
-    int fromType, toType;
-    int toVal;
-    
-    // GET KILLER MOVES
-    uint16_t killer1 = KillerMoves[height][0];
-    uint16_t killer2 = KillerMoves[height][1];
-    
-    for (i = 0; i < size; i++){
-        
-        // TABLEMOVE FIRST
-        value  = 16384 * ( tableMove == moves[i]);
-        
-        // THEN KILLERS, UNLESS OTHER GOOD CAPTURE
-        value += 256   * (   killer1 == moves[i]);
-        value += 256   * (   killer2 == moves[i]);
-        
-        // INFO FOR POSSIBLE CAPTURE
-        fromType = PieceType(board->squares[MoveFrom(moves[i])]);
-        toType = PieceType(board->squares[MoveTo(moves[i])]);
-        toVal = PieceValues[toType];
-        
-        // ENCOURAGE CAPTURING HIGH VALUE
-        value += 5 * toVal;
-        
-        // ENPASS CAPTURE IS TREATED SEPERATLY
-        if (MoveType(moves[i]) == ENPASS_MOVE)
-            value += 2*PawnValue;
-        
-        // WE ARE ONLY CONCERED WITH QUEEN PROMOTIONS
-        else if (MoveType(moves[i]) & PROMOTE_TO_QUEEN)
-            value += 5*QueenValue;
-        
-        // CASTLING IS USUALLY A GOOD MOVE
-        else if (MoveType(moves[i]) == CASTLE_MOVE)
-            value += 256;
-        
-        // PIECE SQUARE TABLE ORDERING
-        value += PSQTopening[fromType][MoveTo(moves[i])] - PSQTopening[fromType][MoveFrom(moves[i])];
-        
-        // HISTORY ORDERING
-        value += getHistoryScore(History, moves[i], board->turn, 512);
-        
-        values[i] = value;
-    }
-}
-
-uint16_t getNextMove(uint16_t * moves, int * values, int index, int size){
-    int i, best = 0;
-    uint16_t bestMove;
-    
-    // FIND GREATEST VALUE
-    for (i = 1; i < size - index; i++)
-        if (values[i] > values[best])
-            best = i;
-        
-    bestMove = moves[best];
-    
-    // MOVE LAST PAIR TO BEST SO WE
-    // CAN REDUCE THE EFFECTIVE LIST SIZE
-    moves[best] = moves[size-index-1];
-    values[best] = values[size-index-1];
-    
-    return bestMove;
-}
-
-void sortMoveList(MoveList * moveList){
+void sortMoveList(MoveList * moveList, int start){
     int i, j, tempVal;
     uint16_t tempMove;
     
-    for (i = 0; i < moveList->size; i++){
+    for (i = start; i < moveList->size; i++){
         for (j = i+1; j < moveList->size; j++){
             if (moveList->values[j] > moveList->values[i]){
                 
@@ -718,4 +1099,35 @@ int canDoNull(Board * board){
     uint64_t pawns = board->pieces[0];
     
     return (friendly & (kings | pawns)) != friendly;
-}
\ No newline at end of file
+}
+
+/**
+ * Determine if the position is drawn by repetition. Positions before the
+ * last irreversible move can not repeat, so the scan is bounded by the
+ * fifty move counter. Nor can positions before the last null move, which
+ * is not a legal move. Most positions have never been seen before, which
+ * the repetition filter, a count of the history keyed by the low bits of
+ * each hash, reveals without any scan at all. A single repetition within
+ * the tree is scored as a draw, as either side could repeat it again.
+ * Positions from before the root must have occured twice already.
+ *
+ * @param   board   Board to check for a repetition
+ * @param   height  Distance from the root of the search
+ *
+ * @return          1 if the position is a repetition, 0 otherwise
+ */
+int isRepetition(Board * board, int height){
+    
+    int i, reps = 0;
+    int start = board->numMoves - MIN(board->fiftyMoveRule, board->pliesFromNull);
+    
+    if (!board->repetitionFilter[board->hash & (REPETITION_FILTER_SIZE - 1)])
+        return 0;
+    
+    for (i = board->numMoves - 2; i >= 0 && i >= start; i -= 2)
+        if (    board->history[i] == board->hash
+            && (i > board->numMoves - height || ++reps == 2))
+            return 1;
+    
+    return 0;
+}
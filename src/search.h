@@ -23,28 +23,65 @@
 
 #include "types.h"
 
-uint16_t getBestMove(SearchInfo * info);
+void initalizeSearch();
 
-int aspirationWindow(PVariation * PV, Board * board, MoveList * moveList, 
-                                               int depth, int lastScore);
+uint16_t getBestMove(Thread * thread, SearchInfo * info, uint16_t * ponderMove);
 
-int rootSearch(PVariation * PV, Board * board, MoveList * moveList, int alpha,
-                                                         int beta, int depth);
+void printSearchInformation(Thread * thread, PVariation * pv, int depth,
+                                                  int value, int multiPV);
 
-int alphaBetaSearch(PVariation * PV, Board * board, int alpha, int beta, 
-                                   int depth, int height, int nodeType);
+int aspirationWindow(Thread * thread, MoveList * moveList, int depth,
+                                                          int lastScore);
 
-int quiescenceSearch(Board * board, int alpha, int beta, int height);
+int rootSearch(Thread * thread, MoveList * moveList, int alpha, int beta,
+                                                              int depth);
 
-void sortMoveList(MoveList * moveList);
+int alphaBetaSearch(Thread * thread, int alpha, int beta, int depth,
+                                              int height, int nodeType);
+
+int quiescenceSearch(Thread * thread, int alpha, int beta, int height);
+
+void sortMoveList(MoveList * moveList, int start);
 
 int canDoNull(Board * board);
 
+int isRepetition(Board * board, int height);
+
+#define USE_RAZORING                        (1)
 #define USE_STATIC_NULL_PRUNING             (1)
 #define USE_FUTILITY_PRUNING                (1)
 #define USE_NULL_MOVE_PRUNING               (1)
 #define USE_LATE_MOVE_REDUCTIONS            (1)
 #define USE_INTERNAL_ITERATIVE_DEEPENING    (1)
 #define USE_TRANSPOSITION_TABLE             (1)
+#define USE_CUCKOO_CYCLES                   (1)
+#define USE_SINGULAR_EXTENSIONS             (1)
+#define USE_LATE_MOVE_PRUNING               (1)
+#define USE_HISTORY_PRUNING                 (1)
+#define USE_PROBCUT                         (1)
+
+#define TIME_CHECK_NODES                    (1024)
+
+#define RAZOR_DEPTH                         (2)
+#define RAZOR_MARGIN                        (300)
+
+#define STATIC_NULL_PRUNING_DEPTH           (3)
+#define STATIC_NULL_PRUNING_MARGIN          (PawnValue + 15)
+
+#define LATE_MOVE_PRUNING_DEPTH             (8)
+#define HISTORY_PRUNING_DEPTH               (3)
+#define HISTORY_PRUNING_MARGIN              (2048)
+
+#define LMR_HISTORY_DIVISOR                 (8192)
+
+#define PROBCUT_DEPTH                       (5)
+#define PROBCUT_MARGIN                      (100)
+
+#define MAX_MULTI_PV                        (64)
+
+#define VALUE_NONE                          (MATE + 1)
+
+#define MIN(A, B) ((A) < (B) ? (A) : (B))
+#define MAX(A, B) ((A) > (B) ? (A) : (B))
 
 #endif
\ No newline at end of file
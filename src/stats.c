@@ -0,0 +1,169 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "stats.h"
+#include "types.h"
+
+/**
+ * Reset all of the counters of a SearchStats.
+ *
+ * @param   stats   Statistics to clear
+ */
+void clearStatistics(SearchStats * stats){
+    memset(stats, 0, sizeof(SearchStats));
+}
+
+/**
+ * Add the counters of one SearchStats to another. Every field is a
+ * uint64_t, so the structures may be summed as flat arrays.
+ *
+ * @param   target  Statistics to accumulate into
+ * @param   source  Statistics to add to the target
+ */
+void mergeStatistics(SearchStats * target, SearchStats * source){
+    
+    int i;
+    uint64_t * dest = (uint64_t *)target;
+    uint64_t * from = (uint64_t *)source;
+    
+    for (i = 0; i < (int)(sizeof(SearchStats) / sizeof(uint64_t)); i++)
+        dest[i] += from[i];
+}
+
+/**
+ * Print the counters of a SearchStats, along with the rates derived
+ * from them, in a form meant to be read while testing changes.
+ *
+ * @param   stats   Statistics to print
+ */
+void printStatistics(SearchStats * stats){
+    
+    uint64_t total = stats->searchNodes + stats->qsearchNodes;
+    
+    printf("Search Nodes       : %"PRIu64"\n", stats->searchNodes);
+    printf("Quiescence Nodes   : %"PRIu64" (%.2f%%)\n", stats->qsearchNodes,
+           100.0 * statisticsRatio(stats->qsearchNodes, total));
+    
+    printf("Table Hits         : %"PRIu64" / %"PRIu64" (%.2f%%)\n",
+           stats->tableHits, stats->tableProbes,
+           100.0 * statisticsRatio(stats->tableHits, stats->tableProbes));
+    
+    printf("Table Cutoffs      : %"PRIu64" (%.2f%%)\n", stats->tableCutoffs,
+           100.0 * statisticsRatio(stats->tableCutoffs, stats->tableProbes));
+    
+    printf("First Move Cutoffs : %"PRIu64" / %"PRIu64" (%.2f%%)\n",
+           stats->failHighsFirst, stats->failHighs,
+           100.0 * statisticsRatio(stats->failHighsFirst, stats->failHighs));
+    
+    printf("Null Move Cutoffs  : %"PRIu64" / %"PRIu64" (%.2f%%)\n",
+           stats->nullMoveCutoffs, stats->nullMoveTries,
+           100.0 * statisticsRatio(stats->nullMoveCutoffs, stats->nullMoveTries));
+    
+    printf("ProbCut Cutoffs    : %"PRIu64" / %"PRIu64" (%.2f%%)\n",
+           stats->probCutCutoffs, stats->probCutTries,
+           100.0 * statisticsRatio(stats->probCutCutoffs, stats->probCutTries));
+    
+    printf("Razor Prunes       : %"PRIu64"\n", stats->razorPrunes);
+    printf("Static Null Prunes : %"PRIu64"\n", stats->staticNullPrunes);
+    printf("Futility Prunes    : %"PRIu64"\n", stats->futilityPrunes);
+    printf("Delta Prunes       : %"PRIu64"\n", stats->deltaPrunes);
+    printf("Late Move Prunes   : %"PRIu64"\n", stats->lateMovePrunes);
+    printf("History Prunes     : %"PRIu64"\n", stats->historyPrunes);
+    
+    printf("LMR Re-searches    : %"PRIu64" / %"PRIu64" (%.2f%%)\n",
+           stats->reducedResearches, stats->reducedSearches,
+           100.0 * statisticsRatio(stats->reducedResearches, stats->reducedSearches));
+    
+    printf("PVS Re-searches    : %"PRIu64"\n", stats->nullWindowResearches);
+    
+    printf("Singular Extensions: %"PRIu64" / %"PRIu64" (%.2f%%)\n",
+           stats->singularExtensions, stats->singularSearches,
+           100.0 * statisticsRatio(stats->singularExtensions, stats->singularSearches));
+    
+    printf("Picked Moves       : table %"PRIu64" noisy %"PRIu64
+           " killer %"PRIu64" quiet %"PRIu64"\n",
+           stats->pickedTable, stats->pickedNoisy,
+           stats->pickedKiller, stats->pickedQuiet);
+    
+    fflush(stdout);
+}
+
+/**
+ * Print the counters of a SearchStats, along with the rates derived
+ * from them, as a single JSON object so that runs may be compared by
+ * scripts.
+ *
+ * @param   stats   Statistics to print
+ */
+void printStatisticsJSON(SearchStats * stats){
+    
+    uint64_t total = stats->searchNodes + stats->qsearchNodes;
+    
+    printf("{");
+    printf("\"searchNodes\": %"PRIu64", ", stats->searchNodes);
+    printf("\"qsearchNodes\": %"PRIu64", ", stats->qsearchNodes);
+    printf("\"tableProbes\": %"PRIu64", ", stats->tableProbes);
+    printf("\"tableHits\": %"PRIu64", ", stats->tableHits);
+    printf("\"tableCutoffs\": %"PRIu64", ", stats->tableCutoffs);
+    printf("\"failHighs\": %"PRIu64", ", stats->failHighs);
+    printf("\"failHighsFirst\": %"PRIu64", ", stats->failHighsFirst);
+    printf("\"nullMoveTries\": %"PRIu64", ", stats->nullMoveTries);
+    printf("\"nullMoveCutoffs\": %"PRIu64", ", stats->nullMoveCutoffs);
+    printf("\"probCutTries\": %"PRIu64", ", stats->probCutTries);
+    printf("\"probCutCutoffs\": %"PRIu64", ", stats->probCutCutoffs);
+    printf("\"razorPrunes\": %"PRIu64", ", stats->razorPrunes);
+    printf("\"staticNullPrunes\": %"PRIu64", ", stats->staticNullPrunes);
+    printf("\"futilityPrunes\": %"PRIu64", ", stats->futilityPrunes);
+    printf("\"deltaPrunes\": %"PRIu64", ", stats->deltaPrunes);
+    printf("\"lateMovePrunes\": %"PRIu64", ", stats->lateMovePrunes);
+    printf("\"historyPrunes\": %"PRIu64", ", stats->historyPrunes);
+    printf("\"reducedSearches\": %"PRIu64", ", stats->reducedSearches);
+    printf("\"reducedResearches\": %"PRIu64", ", stats->reducedResearches);
+    printf("\"nullWindowResearches\": %"PRIu64", ", stats->nullWindowResearches);
+    printf("\"singularSearches\": %"PRIu64", ", stats->singularSearches);
+    printf("\"singularExtensions\": %"PRIu64", ", stats->singularExtensions);
+    printf("\"pickedTable\": %"PRIu64", ", stats->pickedTable);
+    printf("\"pickedNoisy\": %"PRIu64", ", stats->pickedNoisy);
+    printf("\"pickedKiller\": %"PRIu64", ", stats->pickedKiller);
+    printf("\"pickedQuiet\": %"PRIu64", ", stats->pickedQuiet);
+    printf("\"qsearchShare\": %.4f, ", statisticsRatio(stats->qsearchNodes, total));
+    printf("\"tableHitRate\": %.4f, ", statisticsRatio(stats->tableHits, stats->tableProbes));
+    printf("\"firstMoveCutoffRate\": %.4f, ", statisticsRatio(stats->failHighsFirst, stats->failHighs));
+    printf("\"nullMoveSuccessRate\": %.4f, ", statisticsRatio(stats->nullMoveCutoffs, stats->nullMoveTries));
+    printf("\"reducedResearchRate\": %.4f", statisticsRatio(stats->reducedResearches, stats->reducedSearches));
+    printf("}\n");
+    
+    fflush(stdout);
+}
+
+/**
+ * Compute a ratio between two counters, treating an empty
+ * denominator as a ratio of zero rather than dividing by it.
+ *
+ * @param   numerator   Counter of successful events
+ * @param   denominator Counter of all events
+ *
+ * @return              Ratio of the two counters
+ */
+double statisticsRatio(uint64_t numerator, uint64_t denominator){
+    return denominator == 0 ? 0.0 : (double)numerator / denominator;
+}
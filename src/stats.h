@@ -0,0 +1,42 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _STATS_H
+#define _STATS_H
+
+#include "types.h"
+
+// Search statistics are only gathered when building with
+// -DSTATS, since the counters slow down the search slightly
+#ifdef STATS
+    #define STATISTICS (1)
+#else
+    #define STATISTICS (0)
+#endif
+
+void clearStatistics(SearchStats * stats);
+
+void mergeStatistics(SearchStats * target, SearchStats * source);
+
+void printStatistics(SearchStats * stats);
+
+void printStatisticsJSON(SearchStats * stats);
+
+double statisticsRatio(uint64_t numerator, uint64_t denominator);
+
+#endif
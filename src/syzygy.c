@@ -0,0 +1,194 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+
+#include "bitutils.h"
+#include "move.h"
+#include "piece.h"
+#include "syzygy.h"
+#include "types.h"
+
+#ifdef SYZYGY
+    #include "tbprobe.h"
+#endif
+
+/**
+ * Load the Syzygy tablebases found in the given path. Fathom maps the
+ * table files into memory, so several engines probing the same tables
+ * will share the operating system's page cache.
+ *
+ * @param   path    Directories containing the tables, or <empty>
+ *
+ * @return          Largest number of pieces covered by the tables
+ */
+int initalizeSyzygy(char * path){
+    
+#ifdef SYZYGY
+    tb_init(path);
+    return (int)TB_LARGEST;
+#else
+    (void)path;
+    return 0;
+#endif
+}
+
+/**
+ * Probe the Win-Draw-Loss tables for a position within the search. The
+ * WDL tables know nothing of the fifty move rule, so they may only be
+ * trusted just after a capture or pawn move, and Fathom cannot probe
+ * positions which still have castle rights. Wins and losses are scored
+ * just below a mate, while cursed wins and blessed losses are draws.
+ *
+ * @param   board   Board to look up in the tables
+ * @param   height  Distance from the root, used to prefer shorter wins
+ * @param   value   Set to the value of the position if found
+ *
+ * @return          1 if the position was found, 0 otherwise
+ */
+int probeSyzygyWDL(Board * board, int height, int * value){
+    
+#ifdef SYZYGY
+    
+    unsigned result;
+    
+    if (   board->castleRights
+        || board->fiftyMoveRule
+        || popcount(board->colours[WHITE] | board->colours[BLACK]) > (int)TB_LARGEST)
+        return 0;
+    
+    result = tb_probe_wdl(
+        board->colours[WHITE],  board->colours[BLACK],
+        board->pieces[KING],    board->pieces[QUEEN],
+        board->pieces[ROOK],    board->pieces[BISHOP],
+        board->pieces[KNIGHT],  board->pieces[PAWN],
+        0, 0, board->epSquare == -1 ? 0 : board->epSquare,
+        board->turn == WHITE
+    );
+    
+    if (result == TB_RESULT_FAILED)
+        return 0;
+    
+    *value = result == TB_WIN  ?  MATE - MAX_HEIGHT - height
+           : result == TB_LOSS ? -MATE + MAX_HEIGHT + height : 0;
+    
+    return 1;
+    
+#else
+    (void)board; (void)height; (void)value;
+    return 0;
+#endif
+}
+
+/**
+ * Probe the Distance-To-Zero tables for the root position, and remove
+ * each root move which would throw away the tablebase result. When the
+ * position is won or lost, only the move Fathom ranks best by distance
+ * to zero is kept, which guarantees progress under the fifty move rule.
+ * Drawn positions keep every drawing move for the search to choose from.
+ *
+ * @param   board       Board at the root of the search
+ * @param   moveList    Legal moves from the root, filtered in place
+ *
+ * @return              1 if the moves were filtered, 0 otherwise
+ */
+int probeSyzygyRoot(Board * board, MoveList * moveList){
+    
+#ifdef SYZYGY
+    
+    int i, j, size = 0;
+    unsigned result, wdl, results[TB_MAX_MOVES];
+    
+    if (   board->castleRights
+        || popcount(board->colours[WHITE] | board->colours[BLACK]) > (int)TB_LARGEST)
+        return 0;
+    
+    result = tb_probe_root(
+        board->colours[WHITE],  board->colours[BLACK],
+        board->pieces[KING],    board->pieces[QUEEN],
+        board->pieces[ROOK],    board->pieces[BISHOP],
+        board->pieces[KNIGHT],  board->pieces[PAWN],
+        board->fiftyMoveRule, 0, board->epSquare == -1 ? 0 : board->epSquare,
+        board->turn == WHITE, results
+    );
+    
+    if (   result == TB_RESULT_FAILED
+        || result == TB_RESULT_CHECKMATE
+        || result == TB_RESULT_STALEMATE)
+        return 0;
+    
+    wdl = TB_GET_WDL(result);
+    
+    for (i = 0; i < moveList->size; i++){
+        
+        // Won and lost positions keep only the move Fathom selected
+        if (wdl == TB_WIN || wdl == TB_LOSS){
+            if (syzygyMoveMatches(moveList->moves[i], result))
+                moveList->moves[size++] = moveList->moves[i];
+            continue;
+        }
+        
+        // Otherwise keep every move which preserves the result
+        for (j = 0; results[j] != TB_RESULT_FAILED; j++){
+            if (   syzygyMoveMatches(moveList->moves[i], results[j])
+                && TB_GET_WDL(results[j]) == wdl){
+                moveList->moves[size++] = moveList->moves[i];
+                break;
+            }
+        }
+    }
+    
+    // Never leave the search without any moves
+    if (size == 0)
+        return 0;
+    
+    moveList->size = size;
+    return 1;
+    
+#else
+    (void)board; (void)moveList;
+    return 0;
+#endif
+}
+
+/**
+ * Determine if one of our moves is the move described by a result from
+ * Fathom. Fathom numbers the squares as we do, but orders the promotion
+ * pieces from the queen down to the knight, with zero for no promotion.
+ *
+ * @param   move    Move to compare
+ * @param   result  Result from a Fathom root probe
+ *
+ * @return          1 if the move and result match, 0 otherwise
+ */
+int syzygyMoveMatches(uint16_t move, unsigned result){
+    
+#ifdef SYZYGY
+    
+    unsigned promo = MoveType(move) == PROMOTION_MOVE
+                   ? 4 - (MovePromoType(move) >> 14) : 0;
+    
+    return MoveFrom(move) == (int)TB_GET_FROM(result)
+        && MoveTo(move)   == (int)TB_GET_TO(result)
+        && promo          == TB_GET_PROMOTES(result);
+    
+#else
+    (void)move; (void)result;
+    return 0;
+#endif
+}
@@ -0,0 +1,40 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _SYZYGY_H
+#define _SYZYGY_H
+
+#include "types.h"
+
+// Tablebase probing relies on the Fathom library, and is only
+// available when building with -DSYZYGY, see make syzygy
+#ifdef SYZYGY
+    #define USE_SYZYGY (1)
+#else
+    #define USE_SYZYGY (0)
+#endif
+
+int initalizeSyzygy(char * path);
+
+int probeSyzygyWDL(Board * board, int height, int * value);
+
+int probeSyzygyRoot(Board * board, MoveList * moveList);
+
+int syzygyMoveMatches(uint16_t move, unsigned result);
+
+#endif
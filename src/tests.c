@@ -17,7 +17,9 @@
 */
 
 
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "bitboards.h"
 #include "tests.h"
@@ -28,8 +30,10 @@
 #include "movegen.h"
 #include "movepicker.h"
 #include "search.h"
+#include "transposition.h"
+#include "uci.h"
 
-extern HistoryTable History;
+Thread TestThread;
 
 int searchDepth = 5;
 
@@ -188,6 +192,18 @@ char * testPositions[126] = {
     "n1n5/PPPk4/8/8/8/8/4Kppp/5N1N b - - 0 1 ",
 };
 
+int numberOfSearchTests = 1;
+
+// The KPK win must promote to a Queen, rather than to the Rook of a
+// different known win
+char * searchTestPositions[1] = {
+    "8/4P3/8/8/8/3k4/8/4K3 w - - 0 1",
+};
+
+int searchTestDepths[1] = { 12 };
+
+char * searchTestMoves[1] = { "e7e8q" };
+
 void runTestSuite(){
     
     int i;
@@ -195,7 +211,7 @@ void runTestSuite(){
     int found, expected;
     
     // Needed to avoid division by zero
-    clearHistory(History);
+    clearHistory(TestThread.history);
     
     // Run through each test position
     for (i = 0; i < numberOfTests; i++){
@@ -213,6 +229,41 @@ void runTestSuite(){
     }
     
     printf("\nALL TEST POSITIONS FINISHED\n");
+    
+    // Verify the moves chosen in positions with a single correct answer
+    for (i = 0; i < numberOfSearchTests; i++){
+        printf("Searching %s\n", searchTestPositions[i]);
+        searchTesting(searchTestPositions[i], searchTestDepths[i], searchTestMoves[i]);
+    }
+    
+    printf("\nALL SEARCH POSITIONS FINISHED\n");
+}
+
+void searchTesting(char * fen, int depth, char * expected){
+    
+    uint16_t bestMove, ponderMove;
+    char moveStr[6];
+    
+    SearchInfo info;
+    Thread * thread = calloc(1, sizeof(Thread));
+    
+    memset(&info, 0, sizeof(SearchInfo));
+    info.searchIsDepthLimited = 1;
+    info.searchIsSilent = 1;
+    info.depthLimit = depth;
+    info.multiPV = 1;
+    
+    initalizeBoard(&info.board, fen);
+    clearTranspositionTable(&Table);
+    thread->table = &Table;
+    
+    bestMove = getBestMove(thread, &info, &ponderMove);
+    moveToString(moveStr, bestMove);
+    
+    if (strcmp(moveStr, expected))
+        printf("Invalid bestmove [%s instead of %s]\n", moveStr, expected);
+    
+    free(thread);
 }
 
 int perftTesting(Board * board, int depth){
@@ -284,7 +335,7 @@ int perftTesting(Board * board, int depth){
     /* Verification that the move picker will go through
        every move presented for a given position */
        
-    initalizeMovePicker(&mp, 0, NULL_MOVE, NULL_MOVE, NULL_MOVE);
+    initalizeMovePicker(&mp, &TestThread, 0, 0, NULL_MOVE, NULL_MOVE, NULL_MOVE);
     while ((move = selectNextMove(&mp, board)) != NONE_MOVE){
         selectionMoves[selectionSize++] = move;
     }
@@ -23,6 +23,7 @@
 
 void runTestSuite();
 int perftTesting(Board * board, int depth);
+void searchTesting(char * fen, int depth, char * expected);
 void printMoveErrorMessage(Board * board, uint16_t move, char * msg);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,532 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef TUNE
+
+#include <assert.h>
+#include <math.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bitutils.h"
+#include "board.h"
+#include "evaluate.h"
+#include "move.h"
+#include "piece.h"
+#include "search.h"
+#include "texel.h"
+#include "transposition.h"
+#include "types.h"
+
+/**
+ * Tune the evaluation weights using the Texel method. Each labeled
+ * position is resolved to a quiet leaf with the quiescence search, and
+ * the evaluation of that leaf is recorded as a linear function of the
+ * evaluation weights. We then minimize the error between the game
+ * results and sigmoid(K * eval) with (AdaGrad) gradient descent, spread
+ * across all available cores with OpenMP. The tuned weights are printed
+ * in the same form as they appear in evaluate.c every REPORTING epochs.
+ *
+ * @param   fname   File of FENs, each followed by the game result
+ */
+void runTexelTuning(char * fname){
+
+    int i, j, epoch, nentries;
+    double K, error, best = 1e9;
+
+    TexelEntry * entries;
+    TVector params, diffs, gradient, accumulators, current;
+    int tied[NTERMS];
+
+    // Starting values come directly from evaluate.c
+    initalizeParameters(params, tied);
+    memset(diffs, 0, sizeof(TVector));
+    memset(accumulators, 0, sizeof(TVector));
+
+    printf("Tuning %d terms\n", NTERMS);
+
+    nentries = initalizeTexelEntries(&entries, fname);
+    if (nentries == 0){
+        printf("Unable to read any positions from %s\n", fname);
+        return;
+    }
+
+    K = computeOptimalK(entries, nentries);
+    printf("Optimal K = %g\n", K);
+
+    for (epoch = 1; epoch <= MAXEPOCHS; epoch++){
+
+        computeGradient(entries, nentries, gradient, diffs, K);
+
+        for (i = 0; i < NTERMS; i++){
+
+            // Terms shared by both phases move as a single value
+            if (tied[i])
+                gradient[i][MG] = gradient[i][EG] = gradient[i][MG] + gradient[i][EG];
+
+            for (j = MG; j <= EG; j++){
+                gradient[i][j] *= 2.0 / nentries;
+                accumulators[i][j] += gradient[i][j] * gradient[i][j];
+                diffs[i][j] += LEARNING * gradient[i][j] / sqrt(1e-8 + accumulators[i][j]);
+            }
+        }
+
+        if (epoch % REPORTING == 0){
+
+            error = completeEvaluationError(entries, nentries, diffs, K);
+            printf("\nEpoch %d Error = %.8f\n\n", epoch, error);
+
+            for (i = 0; i < NTERMS; i++)
+                for (j = MG; j <= EG; j++)
+                    current[i][j] = params[i][j] + diffs[i][j];
+
+            printParameters(current);
+            fflush(stdout);
+
+            // Stop once an entire report period no longer helps
+            if (best - error < 1e-9) break;
+            best = error;
+        }
+    }
+}
+
+/**
+ * Read every labeled position from the file, one line at a time, and
+ * reduce each to a sparse list of evaluation coefficients. A line is a
+ * FEN followed by the result, either as [1.0], [0.5], [0.0] or as the
+ * PGN style 1-0, 1/2-1/2, 0-1, from the perspective of White.
+ *
+ * @param   entries Location to allocate the entries
+ * @param   fname   File of FENs and results
+ *
+ * @return          Number of entries which were read
+ */
+int initalizeTexelEntries(TexelEntry ** entries, char * fname){
+
+    int i, nentries = 0, capacity = 0, phase, tupleIndex = TUPLESTACK;
+    int (*coeffs)[COLOUR_NB] = (void *)&T;
+    char line[512];
+    float result;
+
+    Undo undo[1];
+    SearchInfo info;
+    TexelTuple * tuples = NULL;
+    Thread * thread = calloc(1, sizeof(Thread));
+    Board * board = &info.board;
+
+    FILE * fin = fopen(fname, "r");
+    if (fin == NULL) return 0;
+
+    *entries = NULL;
+    memset(&info, 0, sizeof(SearchInfo));
+    thread->info = &info;
+    thread->table = &Table;
+    initalizePawnTable(&thread->ptable);
+
+    while (fgets(line, sizeof(line), fin) != NULL){
+
+        if      (strstr(line, "[1.0]") || strstr(line, "1-0"))     result = 1.0;
+        else if (strstr(line, "[0.5]") || strstr(line, "1/2-1/2")) result = 0.5;
+        else if (strstr(line, "[0.0]") || strstr(line, "0-1"))     result = 0.0;
+        else continue;
+
+        // Grow the list of entries as we go, the file may be huge
+        if (nentries == capacity){
+            capacity = capacity ? 2 * capacity : (1 << 16);
+            *entries = realloc(*entries, capacity * sizeof(TexelEntry));
+        }
+
+        // Resolve the position to a quiet leaf of the quiescence search
+        initalizeBoard(board, line);
+        thread->evaluatingPlayer = board->turn;
+        quiescenceSearch(thread, -MATE, MATE, 0);
+        for (i = 0; i < thread->pvs[0].length; i++)
+            applyMove(board, thread->pvs[0].line[i], undo);
+
+        // Trace the evaluation of the leaf from White's perspective
+        T = EmptyTrace;
+        (*entries)[nentries].eval = evaluateBoard(board, &thread->ptable);
+        if (board->turn == BLACK) (*entries)[nentries].eval *= -1;
+
+        phase = 24 - popcount(board->pieces[KNIGHT] | board->pieces[BISHOP])
+                   - 2 * popcount(board->pieces[ROOK])
+                   - 4 * popcount(board->pieces[QUEEN]);
+        phase = (phase * 256 + 12) / 24;
+
+        (*entries)[nentries].result = result;
+        (*entries)[nentries].factors[MG] = (256 - phase) / 256.0;
+        (*entries)[nentries].factors[EG] = phase / 256.0;
+
+        // Tuples are allocated in blocks which are never moved
+        if (tupleIndex + NTERMS > TUPLESTACK){
+            tuples = malloc(TUPLESTACK * sizeof(TexelTuple));
+            tupleIndex = 0;
+        }
+
+        (*entries)[nentries].tuples = tuples + tupleIndex;
+        (*entries)[nentries].ntuples = 0;
+
+        // Only save the terms which do not cancel out
+        for (i = 0; i < NTERMS; i++){
+            if (coeffs[i][WHITE] - coeffs[i][BLACK] != 0){
+                tuples[tupleIndex].index = i;
+                tuples[tupleIndex].coeff = coeffs[i][WHITE] - coeffs[i][BLACK];
+                (*entries)[nentries].ntuples++;
+                tupleIndex++;
+            }
+        }
+
+        if (++nentries % 100000 == 0){
+            printf("\rLoaded %d positions", nentries);
+            fflush(stdout);
+        }
+    }
+
+    printf("\rLoaded %d positions\n", nentries);
+
+    fclose(fin);
+    destoryPawnTable(&thread->ptable);
+    free(thread);
+    return nentries;
+}
+
+static void initalizePhased(TVector params, int * tied, int * index,
+                             const int * mg, const int * eg, int length){
+
+    int i;
+
+    for (i = 0; i < length; i++, (*index)++){
+        params[*index][MG] = mg[i];
+        params[*index][EG] = eg[i];
+        tied[*index] = 0;
+    }
+}
+
+static void initalizeTied(TVector params, int * tied, int * index,
+                                       const int * values, int length){
+
+    int i;
+
+    for (i = 0; i < length; i++, (*index)++){
+        params[*index][MG] = values[i];
+        params[*index][EG] = values[i];
+        tied[*index] = 1;
+    }
+}
+
+/**
+ * Fill the parameter vector with the current evaluation weights. The
+ * order here must exactly match the order of the fields in EvalTrace.
+ * Weights which are used for both the mid and end game are tied.
+ *
+ * @param   params  Parameter vector to fill
+ * @param   tied    Flags for terms shared by both phases
+ */
+void initalizeParameters(TVector params, int * tied){
+
+    int i = 0;
+
+    const int stacked[PHASE_NB]  = {PAWN_STACKED_MID, PAWN_STACKED_END};
+    const int isolated[PHASE_NB] = {PAWN_ISOLATED_MID, PAWN_ISOLATED_END};
+    const int openFile[PHASE_NB] = {ROOK_OPEN_FILE_MID, ROOK_OPEN_FILE_END};
+    const int semiFile[PHASE_NB] = {ROOK_SEMI_FILE_MID, ROOK_SEMI_FILE_END};
+    const int on7th[PHASE_NB]    = {ROOK_ON_7TH_MID, ROOK_ON_7TH_END};
+    const int castled  = KING_HAS_CASTLED;
+    const int canCastle = KING_CAN_CASTLE;
+
+    initalizePhased(params, tied, &i, &stacked[MG], &stacked[EG], 1);
+    initalizePhased(params, tied, &i, &isolated[MG], &isolated[EG], 1);
+    initalizeTied(params, tied, &i, PawnConnected[WHITE], SQUARE_NB);
+    initalizePhased(params, tied, &i, KnightOutpostValues[MG], KnightOutpostValues[EG], 2);
+    initalizePhased(params, tied, &i, BishopOutpostValues[MG], BishopOutpostValues[EG], 2);
+    initalizePhased(params, tied, &i, KnightMobility[MG], KnightMobility[EG], 9);
+    initalizePhased(params, tied, &i, BishopMobility[MG], BishopMobility[EG], 14);
+    initalizePhased(params, tied, &i, RookMobility[MG], RookMobility[EG], 15);
+    initalizePhased(params, tied, &i, QueenMobility[MG], QueenMobility[EG], 28);
+    initalizePhased(params, tied, &i, &BishopHasWings[MG], &BishopHasWings[EG], 1);
+    initalizePhased(params, tied, &i, &BishopPair[MG], &BishopPair[EG], 1);
+    initalizeTied(params, tied, &i, &castled, 1);
+    initalizeTied(params, tied, &i, &canCastle, 1);
+    initalizePhased(params, tied, &i, &openFile[MG], &openFile[EG], 1);
+    initalizePhased(params, tied, &i, &semiFile[MG], &semiFile[EG], 1);
+    initalizePhased(params, tied, &i, &on7th[MG], &on7th[EG], 1);
+    initalizePhased(params, tied, &i, &PawnPassed[MG][0][0][0], &PawnPassed[EG][0][0][0], 32);
+    initalizeTied(params, tied, &i, SafetyTable, 100);
+    initalizePhased(params, tied, &i, &Tempo[MG], &Tempo[EG], 1);
+
+    assert(i == NTERMS);
+}
+
+/**
+ * Find the scaling constant K which best maps the current evaluations
+ * to the game results, refining the search one digit at a time.
+ *
+ * @param   entries     Texel entries to evaluate
+ * @param   nentries    Number of entries
+ *
+ * @return              Best value of K found
+ */
+double computeOptimalK(TexelEntry * entries, int nentries){
+
+    int i;
+    double start = 0.0, end = 10.0, step = 1.0;
+    double curr, error, best;
+    TVector diffs;
+
+    memset(diffs, 0, sizeof(TVector));
+    best = completeEvaluationError(entries, nentries, diffs, start);
+
+    for (i = 0; i < KPRECISION; i++){
+
+        for (curr = start - step; curr < end; ){
+
+            curr = curr + step;
+            error = completeEvaluationError(entries, nentries, diffs, curr);
+
+            if (error <= best){
+                best = error;
+                start = curr;
+            }
+        }
+
+        end = start + step;
+        start = start - step;
+        step = step / 10.0;
+    }
+
+    return start;
+}
+
+/**
+ * Compute the mean squared error between the results and the predicted
+ * results of every entry, given changes to the parameters.
+ *
+ * @param   entries     Texel entries to evaluate
+ * @param   nentries    Number of entries
+ * @param   diffs       Changes from the starting parameters
+ * @param   K           Scaling constant for the sigmoid
+ *
+ * @return              Mean squared error
+ */
+double completeEvaluationError(TexelEntry * entries, int nentries,
+                                           TVector diffs, double K){
+
+    int i;
+    double total = 0.0;
+
+    #pragma omp parallel for schedule(static) reduction(+:total)
+    for (i = 0; i < nentries; i++){
+        double error = entries[i].result - sigmoid(K, linearEvaluation(&entries[i], diffs));
+        total += error * error;
+    }
+
+    return total / nentries;
+}
+
+/**
+ * Compute the direction in which each parameter should move to reduce
+ * the error. Each thread accumulates a private gradient, which are
+ * summed together once every thread has finished its share.
+ *
+ * @param   entries     Texel entries to evaluate
+ * @param   nentries    Number of entries
+ * @param   gradient    Location to store the gradient
+ * @param   diffs       Changes from the starting parameters
+ * @param   K           Scaling constant for the sigmoid
+ */
+void computeGradient(TexelEntry * entries, int nentries, TVector gradient,
+                                                TVector diffs, double K){
+
+    memset(gradient, 0, sizeof(TVector));
+
+    #pragma omp parallel shared(gradient)
+    {
+        int i, j, index;
+        double S, X;
+        TVector local;
+
+        memset(local, 0, sizeof(TVector));
+
+        #pragma omp for schedule(static)
+        for (i = 0; i < nentries; i++){
+
+            S = sigmoid(K, linearEvaluation(&entries[i], diffs));
+            X = (entries[i].result - S) * S * (1 - S);
+
+            for (j = 0; j < entries[i].ntuples; j++){
+                index = entries[i].tuples[j].index;
+                local[index][MG] += X * entries[i].tuples[j].coeff * entries[i].factors[MG];
+                local[index][EG] += X * entries[i].tuples[j].coeff * entries[i].factors[EG];
+            }
+        }
+
+        #pragma omp critical
+        for (i = 0; i < NTERMS; i++){
+            gradient[i][MG] += local[i][MG];
+            gradient[i][EG] += local[i][EG];
+        }
+    }
+}
+
+/**
+ * Evaluate an entry after changes to the parameters. The evaluation is
+ * linear in the parameters, so we only need the original evaluation and
+ * the change contributed by each of the entry's coefficients.
+ *
+ * @param   entry   Texel entry to evaluate
+ * @param   diffs   Changes from the starting parameters
+ *
+ * @return          Evaluation from White's perspective
+ */
+double linearEvaluation(TexelEntry * entry, TVector diffs){
+
+    int i, index;
+    double mg = 0.0, eg = 0.0;
+
+    for (i = 0; i < entry->ntuples; i++){
+        index = entry->tuples[i].index;
+        mg += diffs[index][MG] * entry->tuples[i].coeff;
+        eg += diffs[index][EG] * entry->tuples[i].coeff;
+    }
+
+    return entry->eval + mg * entry->factors[MG] + eg * entry->factors[EG];
+}
+
+double sigmoid(double K, double score){
+    return 1.0 / (1.0 + pow(10.0, -K * score / 400.0));
+}
+
+static int rounded(double value){
+    return (int)(value < 0 ? value - 0.5 : value + 0.5);
+}
+
+static void printList(TVector params, int index, int phase, int length){
+
+    int i;
+
+    printf("{");
+    for (i = 0; i < length; i++){
+        if (i && i % 10 == 0) printf("\n     ");
+        printf("%4d%s", rounded(params[index + i][phase]), i == length - 1 ? "" : ",");
+    }
+    printf("}");
+}
+
+static void printMacro(TVector params, int * index, char * name){
+
+    printf("#define %-20s (%d)\n", name, rounded(params[*index][MG]));
+    (*index)++;
+}
+
+static void printPhasedMacro(TVector params, int * index, char * name){
+
+    char mid[64], end[64];
+
+    sprintf(mid, "%s_MID", name);
+    sprintf(end, "%s_END", name);
+
+    printf("#define %-20s (%d)\n", mid, rounded(params[*index][MG]));
+    printf("#define %-20s (%d)\n", end, rounded(params[*index][EG]));
+    (*index)++;
+}
+
+static void printPhasedArray(TVector params, int * index, char * name, int length){
+
+    if (length == 1){
+        printf("const int %s[PHASE_NB] = {%d, %d};\n\n", name,
+               rounded(params[*index][MG]), rounded(params[*index][EG]));
+        (*index)++;
+        return;
+    }
+
+    printf("const int %s[PHASE_NB][%d] = {\n    ", name, length);
+    printList(params, *index, MG, length);
+    printf(",\n    ");
+    printList(params, *index, EG, length);
+    printf("\n};\n\n");
+
+    *index += length;
+}
+
+/**
+ * Print every parameter in the same form as it is declared in either
+ * evaluate.c or evaluate.h, walking the terms in the EvalTrace order.
+ *
+ * @param   params  Parameters to print
+ */
+void printParameters(TVector params){
+
+    int i = 0, sq, phase, canAdvance;
+
+    printPhasedMacro(params, &i, "PAWN_STACKED");
+    printPhasedMacro(params, &i, "PAWN_ISOLATED");
+    printf("\n");
+
+    printf("const int PawnConnected[COLOUR_NB][SQUARE_NB] = {\n    {");
+    for (sq = 0; sq < SQUARE_NB; sq++)
+        printf("%s%3d,", sq % 8 ? "" : "\n     ", rounded(params[i + sq][MG]));
+    printf(" },\n\n    {");
+    for (sq = 0; sq < SQUARE_NB; sq++)
+        printf("%s%3d,", sq % 8 ? "" : "\n     ", rounded(params[i + (sq ^ 56)][MG]));
+    printf(" }\n};\n\n");
+    i += SQUARE_NB;
+
+    printPhasedArray(params, &i, "KnightOutpostValues", 2);
+    printPhasedArray(params, &i, "BishopOutpostValues", 2);
+    printPhasedArray(params, &i, "KnightMobility", 9);
+    printPhasedArray(params, &i, "BishopMobility", 14);
+    printPhasedArray(params, &i, "RookMobility", 15);
+    printPhasedArray(params, &i, "QueenMobility", 28);
+    printPhasedArray(params, &i, "BishopHasWings", 1);
+    printPhasedArray(params, &i, "BishopPair", 1);
+
+    printMacro(params, &i, "KING_HAS_CASTLED");
+    printMacro(params, &i, "KING_CAN_CASTLE");
+    printPhasedMacro(params, &i, "ROOK_OPEN_FILE");
+    printPhasedMacro(params, &i, "ROOK_SEMI_FILE");
+    printPhasedMacro(params, &i, "ROOK_ON_7TH");
+    printf("\n");
+
+    printf("const int PawnPassed[PHASE_NB][2][2][RANK_NB] = {\n");
+    for (phase = MG; phase <= EG; phase++){
+        printf("   {");
+        for (canAdvance = 0; canAdvance < 2; canAdvance++){
+            printf("{");
+            printList(params, i + 16 * canAdvance + 0, phase, RANK_NB);
+            printf(",\n     ");
+            printList(params, i + 16 * canAdvance + 8, phase, RANK_NB);
+            printf("}%s", canAdvance ? "}" : ",\n\n    ");
+        }
+        printf(",\n");
+    }
+    printf("};\n\n");
+    i += 32;
+
+    printf("const int SafetyTable[100] = {\n    ");
+    printList(params, i, MG, 100);
+    printf("\n};\n\n");
+    i += 100;
+
+    printPhasedArray(params, &i, "Tempo", 1);
+
+    assert(i == NTERMS);
+}
+
+#endif
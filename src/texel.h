@@ -0,0 +1,76 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifdef TUNE
+
+#ifndef _TEXEL_H
+#define _TEXEL_H
+
+#include <stdint.h>
+
+#include "types.h"
+
+// Every field of the EvalTrace is a list of [COLOUR_NB] counters,
+// so the trace may be viewed as a flat array of NTERMS terms
+#define NTERMS      ((int)(sizeof(EvalTrace) / (COLOUR_NB * sizeof(int))))
+
+#define KPRECISION  (     6)  // Digits of precision when computing K
+#define LEARNING    (   1.0)  // Initial step size for AdaGrad
+#define REPORTING   (    50)  // Epochs between printing the parameters
+#define MAXEPOCHS   ( 10000)  // Epochs before giving up on convergence
+#define TUPLESTACK  (1 << 20) // Tuples allocated in each block
+
+typedef double TVector[NTERMS][PHASE_NB];
+
+typedef struct TexelTuple {
+    uint16_t index;
+    int16_t coeff;
+
+} TexelTuple;
+
+typedef struct TexelEntry {
+    int ntuples;
+    float result, eval;
+    float factors[PHASE_NB];
+    TexelTuple * tuples;
+
+} TexelEntry;
+
+void runTexelTuning(char * fname);
+
+int initalizeTexelEntries(TexelEntry ** entries, char * fname);
+
+void initalizeParameters(TVector params, int * tied);
+
+double computeOptimalK(TexelEntry * entries, int nentries);
+
+double completeEvaluationError(TexelEntry * entries, int nentries,
+                                           TVector diffs, double K);
+
+void computeGradient(TexelEntry * entries, int nentries, TVector gradient,
+                                                TVector diffs, double K);
+
+double linearEvaluation(TexelEntry * entry, TVector diffs);
+
+double sigmoid(double K, double score);
+
+void printParameters(TVector params);
+
+#endif
+
+#endif
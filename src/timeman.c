@@ -0,0 +1,168 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include <stdint.h>
+
+#include "move.h"
+#include "timer.h"
+#include "timeman.h"
+#include "types.h"
+
+double MoveOverhead = MOVE_OVERHEAD_DEFAULT;
+
+double Latency = 0.0;
+
+double ExpectedClock = -1;
+
+/**
+ * Determine the time budgets for a search played on the clock. The ideal
+ * usage is the amount of time we expect to spend on a typical move, and
+ * is scaled up or down by updateTimeManagement as the search progresses.
+ * The max usage is a hard limit which the search will only exceed to
+ * complete its first iteration. Every move also loses some time to the
+ * GUI and the network, which we cover with the MoveOverhead option plus
+ * an estimate of the latency, taken from the clock before budgeting.
+ *
+ * @param   info    Search information to set the budgets for
+ * @param   time    Time remaining on our clock
+ * @param   inc     Increment we receive after making the move
+ * @param   mtg     Moves until the next time control, or -1 if none
+ */
+void initalizeTimeManagement(SearchInfo * info, double time, double inc, double mtg){
+    
+    double lag;
+    
+    info->searchIsTimeLimited = 1;
+    info->searchIsTimeManaged = 1;
+    info->clockTime = time;
+    info->clockInc = inc;
+    
+    // Our clock reads less than it would have had our last move been
+    // relayed instantly. Fold the difference into a moving average,
+    // ignoring clocks which were refilled or are otherwise suspect
+    if (ExpectedClock != -1 && time <= ExpectedClock
+        && ExpectedClock - time < LATENCY_OBSERVATION_MAX)
+        Latency = .75 * Latency + .25 * (ExpectedClock - time);
+    ExpectedClock = -1;
+    
+    // Time lost outside of the search is never available to it
+    lag = MoveOverhead + Latency;
+    time = time > lag ? time - lag : 0;
+    
+    // NOT USING REPEATING TIME CONTROL
+    if (mtg == -1)
+        info->idealUsage = time / 40 + .75 * inc;
+    
+    // USING REPEATING TIME CONTROL
+    else
+        info->idealUsage = .75 * time / (mtg + 2);
+    
+    // Allow difficult moves several times the ideal usage, but
+    // never so much of the clock that the next moves are starved
+    info->maxUsage = 5 * info->idealUsage;
+    if (info->maxUsage > .6 * time) info->maxUsage = .6 * time;
+    if (info->idealUsage > info->maxUsage) info->idealUsage = info->maxUsage;
+    
+    // Always search for a moment, even on a clock spent by the lag
+    if (info->maxUsage < MIN_SEARCH_TIME) info->maxUsage = MIN_SEARCH_TIME;
+    if (info->idealUsage < MIN_SEARCH_TIME) info->idealUsage = MIN_SEARCH_TIME;
+    
+    info->endTime1 = info->clockStart + info->idealUsage;
+    info->endTime2 = info->clockStart + info->maxUsage;
+    
+    info->iterationEnd = info->clockStart;
+    info->iterationTime = 0;
+    info->pvStability = 0;
+    info->previousBestMove = NONE_MOVE;
+    info->previousValue = 0;
+}
+
+/**
+ * Note the clock we expect the GUI to report at our next move, after the
+ * time we used for this one and our increment. Any shortfall is latency.
+ *
+ * @param   info    Search information of the move which was just sent
+ */
+void recordMoveTime(SearchInfo * info){
+    
+    double used = getRealTime() - info->clockStart;
+    
+    ExpectedClock = info->clockTime - used + info->clockInc;
+}
+
+/**
+ * Adjust the soft deadline, endTime1, after each completed iteration. A
+ * best move which keeps changing, or a score which falls from one depth
+ * to the next, suggests the position is not yet understood and earns a
+ * longer search. A best move which has held for several iterations lets
+ * the search end sooner.
+ *
+ * @param   info        Search information holding the budgets
+ * @param   depth       Depth of the completed iteration
+ * @param   bestMove    Best move found by the iteration
+ * @param   value       Value of the best move
+ */
+void updateTimeManagement(SearchInfo * info, int depth, uint16_t bestMove, int value){
+    
+    double scale, now = getRealTime();
+    int drop = info->previousValue - value;
+    
+    // Measure the iteration, to predict the cost of the next one
+    info->iterationTime = now - info->iterationEnd;
+    info->iterationEnd = now;
+    
+    // Count the iterations in a row which agreed on the best move
+    if (bestMove == info->previousBestMove)
+        info->pvStability++;
+    else
+        info->pvStability = 0;
+    
+    info->previousBestMove = bestMove;
+    info->previousValue = value;
+    
+    // Early iterations are too noisy to adjust by
+    if (depth < 4) return;
+    
+    // Scale from 1.4 after a change of mind down to 0.8 when stable
+    scale = 1.4 - .1 * (info->pvStability < 6 ? info->pvStability : 6);
+    
+    // Scale up to another 1.5 times for a falling score
+    if (drop > 0)
+        scale *= 1.0 + (drop < 100 ? drop : 100) / 200.0;
+    
+    info->endTime1 = info->clockStart + info->idealUsage * scale;
+    if (info->endTime1 > info->endTime2)
+        info->endTime1 = info->endTime2;
+}
+
+/**
+ * Predict whether another iteration could complete before the hard
+ * deadline, assuming it costs ESTIMATED_BRANCHING_FACTOR times as much
+ * as the last one. An iteration which will be cut short rarely changes
+ * the best move, so the time is better saved for later moves.
+ *
+ * @param   info    Search information holding the budgets
+ *
+ * @return          1 if the next iteration is expected to complete
+ */
+int timeForNextIteration(SearchInfo * info){
+    
+    double expected = ESTIMATED_BRANCHING_FACTOR * info->iterationTime;
+    
+    return getRealTime() + expected < info->endTime2;
+}
@@ -0,0 +1,45 @@
+/*
+  Ethereal is a UCI chess playing engine authored by Andrew Grant.
+  <https://github.com/AndyGrant/Ethereal>     <andrew@grantnet.us>
+  
+  Ethereal is free software: you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation, either version 3 of the License, or
+  (at your option) any later version.
+  
+  Ethereal is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+  
+  You should have received a copy of the GNU General Public License
+  along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef _TIMEMAN_H
+#define _TIMEMAN_H
+
+#include <stdint.h>
+
+#include "types.h"
+
+void initalizeTimeManagement(SearchInfo * info, double time, double inc, double mtg);
+
+void recordMoveTime(SearchInfo * info);
+
+void updateTimeManagement(SearchInfo * info, int depth, uint16_t bestMove, int value);
+
+int timeForNextIteration(SearchInfo * info);
+
+#define ESTIMATED_BRANCHING_FACTOR (2.0)
+
+#define MIN_SEARCH_TIME            (10)
+#define MOVE_OVERHEAD_DEFAULT      (100)
+#define MOVE_OVERHEAD_MAX          (10000)
+#define LATENCY_OBSERVATION_MAX    (1000)
+
+extern double MoveOverhead;
+extern double Latency;
+extern double ExpectedClock;
+
+#endif
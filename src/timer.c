@@ -19,7 +19,8 @@
 #if defined(_WIN32) || defined(_WIN64)
     #include <windows.h>
 #else
-    #include <sys/time.h>
+    #define _POSIX_C_SOURCE 199309L
+    #include <time.h>
 #endif
 
 #include <stdlib.h>
@@ -28,7 +29,9 @@
  * Return the number of millseconds elapsed since
  * any arbitrary point in time. This method should
  * work for any Windows machine and any POSIX 
- * complient or semi-complient machine.
+ * complient or semi-complient machine. The POSIX
+ * version uses the monotonic clock, so that changes
+ * to the system time do not disturb the deadlines.
  *
  * @return  Time elapsed in milliseconds
  */
@@ -36,13 +39,13 @@ double getRealTime(){
 #if defined(_WIN32) || defined(_WIN64)
     return (double)(GetTickCount());
 #else
-    struct timeval tv;
+    struct timespec ts;
 
-    gettimeofday(&tv, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &ts);
     
-    double secsInMilli = ((double)tv.tv_sec) * 1000;
-    double usecsInMilli = tv.tv_usec / 1000;
+    double secsInMilli = ((double)ts.tv_sec) * 1000;
+    double nsecsInMilli = ts.tv_nsec / 1000000.0;
     
-    return (secsInMilli + usecsInMilli);
+    return (secsInMilli + nsecsInMilli);
 #endif
 }
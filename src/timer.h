@@ -16,8 +16,8 @@
   along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
-#ifndef _MY_TIME_H
-#define _MY_TIME_H
+#ifndef _TIMER_H
+#define _TIMER_H
 
 double getRealTime();
 
@@ -18,12 +18,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdint.h>
 #include <assert.h>
 
 #include "move.h"
 #include "types.h"
 #include "transposition.h"
+#include "zorbist.h"
 
 /**
  * Allocate memory for the transposition table and
@@ -200,6 +202,82 @@ void clearTranspositionTable(TransTable * table){
     }
 }
 
+/**
+ * Write the transposition table to a file, so that a later session
+ * may continue from the results of this one. The buckets are written
+ * as a single sequential stream after a header describing the table.
+ *
+ * @param   table   TransTable pointer to table location
+ * @param   fname   Name of the file to write
+ *
+ * @return          1 if the table was saved, 0 otherwise
+ */
+int saveTranspositionTable(TransTable * table, char * fname){
+    
+    TransFileHeader header;
+    FILE * fout = fopen(fname, "wb");
+    if (fout == NULL) return 0;
+    
+    // Zero the padding of the header, so that the file is deterministic
+    memset(&header, 0, sizeof(TransFileHeader));
+    
+    header.magic = TT_FILE_MAGIC;
+    header.version = TT_FILE_VERSION;
+    header.entrySize = sizeof(TransEntry);
+    header.keySize = table->keySize;
+    header.used = table->used;
+    header.fingerprint = zorbistFingerprint();
+    header.generation = table->generation;
+    
+    if (   fwrite(&header, sizeof(TransFileHeader), 1, fout) != 1
+        || fwrite(table->buckets, sizeof(TransBucket), table->numBuckets, fout) != table->numBuckets){
+        fclose(fout);
+        return 0;
+    }
+    
+    return fclose(fout) == 0;
+}
+
+/**
+ * Read a transposition table previously written by saveTranspositionTable.
+ * The file is rejected unless it was written by the same version of the
+ * format, for a table of the same size, using the same zorbist keys. On
+ * a failed read the table is cleared, as it may be partially overwritten.
+ *
+ * @param   table   TransTable pointer to table location
+ * @param   fname   Name of the file to read
+ *
+ * @return          1 if the table was loaded, 0 otherwise
+ */
+int loadTranspositionTable(TransTable * table, char * fname){
+    
+    TransFileHeader header;
+    FILE * fin = fopen(fname, "rb");
+    if (fin == NULL) return 0;
+    
+    if (   fread(&header, sizeof(TransFileHeader), 1, fin) != 1
+        || header.magic != TT_FILE_MAGIC
+        || header.version != TT_FILE_VERSION
+        || header.entrySize != sizeof(TransEntry)
+        || header.keySize != table->keySize
+        || header.fingerprint != zorbistFingerprint()){
+        fclose(fin);
+        return 0;
+    }
+    
+    if (fread(table->buckets, sizeof(TransBucket), table->numBuckets, fin) != table->numBuckets){
+        clearTranspositionTable(table);
+        fclose(fin);
+        return 0;
+    }
+    
+    table->used = header.used;
+    table->generation = header.generation;
+    
+    fclose(fin);
+    return 1;
+}
+
 /**
  * Allocate memory for the pawn structure hash table
  *
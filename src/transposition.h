@@ -36,6 +36,10 @@ void updateTranspositionTable(TransTable * table);
 
 void clearTranspositionTable(TransTable * table);
 
+int saveTranspositionTable(TransTable * table, char * fname);
+
+int loadTranspositionTable(TransTable * table, char * fname);
+
 void initalizePawnTable(PawnTable * ptable);
 
 void destoryPawnTable(PawnTable * ptable);
@@ -46,7 +50,6 @@ void storePawnEntry(PawnTable * ptable, uint64_t phash, uint64_t passed,
                                                         int mg, int eg);
 
 extern TransTable Table;
-extern PawnTable PTable;
 
 #define PVNODE  (1)
 #define CUTNODE (2)
@@ -54,6 +57,9 @@ extern PawnTable PTable;
 
 #define BUCKET_SIZE (4)
 
+#define TT_FILE_MAGIC   (0x4554485441424C45ull) // "ETHTABLE"
+#define TT_FILE_VERSION (1)
+
 #define EntrySetAge(e,a)    ((e)->data = ((a) << 2) | ((e)->data & 3))
 #define EntryDepth(e)       ((e).depth)
 #define EntryHash16(e)      ((e).hash16)
@@ -62,4 +68,7 @@ extern PawnTable PTable;
 #define EntryMove(e)        ((e).bestMove)
 #define EntryValue(e)       ((e).value)
 
+// Key used for searches of a position with one of its moves excluded
+#define ExcludedMoveHash(h,m) ((h) ^ ((uint64_t)(m) * 0x9E3779B97F4A7C15ull))
+
 #endif 
\ No newline at end of file
@@ -28,11 +28,14 @@
 #define MAX_HEIGHT  (128)
 #define MAX_MOVES   (256)
 
+#define REPETITION_FILTER_SIZE  (1024)
+
 #define SQUARE_NB   (64)
 #define COLOUR_NB   ( 2)
 #define RANK_NB     ( 8)
 #define FILE_NB     ( 8)
 #define PHASE_NB    ( 2)
+#define PIECE_NB    ( 6)
 
 typedef struct Board {
     uint8_t squares[SQUARE_NB];
@@ -44,11 +47,13 @@ typedef struct Board {
     int castleRights;
     int epSquare;
     int fiftyMoveRule;
+    int pliesFromNull;
     int opening;
     int endgame;
     int numMoves;
     int hasCastled[2];
     uint64_t history[256];
+    uint8_t repetitionFilter[REPETITION_FILTER_SIZE];
     
 } Board;
 
@@ -59,6 +64,7 @@ typedef struct Undo {
     int castleRights;
     int epSquare;
     int fiftyMoveRule;
+    int pliesFromNull;
     int opening;
     int endgame;
     int captureSquare;
@@ -88,6 +94,17 @@ typedef struct TransTable {
     
 } TransTable;
 
+typedef struct TransFileHeader {
+    uint64_t magic;
+    uint32_t version;
+    uint32_t entrySize;
+    uint64_t keySize;
+    uint64_t used;
+    uint64_t fingerprint;
+    uint8_t generation;
+    
+} TransFileHeader;
+
 typedef struct MoveList {
     uint16_t moves[MAX_MOVES];
     int values[MAX_MOVES];
@@ -101,11 +118,29 @@ typedef struct SearchInfo {
     int searchIsInfinite;
     int searchIsDepthLimited;
     int searchIsTimeLimited;
+    int searchIsTimeManaged;
+    int searchIsNodeLimited;
+    int searchIsSilent;
+    volatile int searchIsPondering;
     int depthLimit;
-    int terminateSearch;
+    uint64_t nodeLimit;
+    int multiPV;
+    int searchMovesSize;
+    uint16_t searchMoves[MAX_MOVES];
+    volatile int terminateSearch;
     double startTime;
     double endTime1;
     double endTime2;
+    double clockStart;
+    double clockTime;
+    double clockInc;
+    double idealUsage;
+    double maxUsage;
+    double iterationEnd;
+    double iterationTime;
+    int pvStability;
+    int previousValue;
+    uint16_t previousBestMove;
     
 } SearchInfo;
 
@@ -127,10 +162,80 @@ typedef struct PVariation {
     
 } PVariation;
 
-typedef uint16_t HistoryTable[COLOUR_NB][SQUARE_NB][SQUARE_NB][2]; 
+typedef int16_t HistoryTable[COLOUR_NB][SQUARE_NB][SQUARE_NB];
+
+typedef int16_t ContinuationTable[2][PIECE_NB][SQUARE_NB][PIECE_NB][SQUARE_NB];
+
+typedef int16_t CaptureHistoryTable[PIECE_NB][SQUARE_NB][PIECE_NB + 1];
+
+typedef struct EvalTrace {
+    int PawnStacked[COLOUR_NB];
+    int PawnIsolated[COLOUR_NB];
+    int PawnConnected[SQUARE_NB][COLOUR_NB];
+    int KnightOutpostValues[2][COLOUR_NB];
+    int BishopOutpostValues[2][COLOUR_NB];
+    int KnightMobility[9][COLOUR_NB];
+    int BishopMobility[14][COLOUR_NB];
+    int RookMobility[15][COLOUR_NB];
+    int QueenMobility[28][COLOUR_NB];
+    int BishopHasWings[COLOUR_NB];
+    int BishopPair[COLOUR_NB];
+    int KingHasCastled[COLOUR_NB];
+    int KingCanCastle[COLOUR_NB];
+    int RookOpenFile[COLOUR_NB];
+    int RookSemiFile[COLOUR_NB];
+    int RookOn7th[COLOUR_NB];
+    int PawnPassed[2][2][RANK_NB][COLOUR_NB];
+    int SafetyTable[100][COLOUR_NB];
+    int Tempo[COLOUR_NB];
+    
+} EvalTrace;
+
+typedef struct Book {
+    uint8_t * data;
+    uint64_t size, entries, seed;
+    int isMapped;
+    
+} Book;
+
+typedef struct SearchStats {
+    uint64_t searchNodes, qsearchNodes;
+    uint64_t tableProbes, tableHits, tableCutoffs;
+    uint64_t failHighs, failHighsFirst;
+    uint64_t nullMoveTries, nullMoveCutoffs;
+    uint64_t probCutTries, probCutCutoffs;
+    uint64_t razorPrunes, staticNullPrunes, futilityPrunes, deltaPrunes;
+    uint64_t reducedSearches, reducedResearches, nullWindowResearches;
+    uint64_t singularSearches, singularExtensions;
+    uint64_t lateMovePrunes, historyPrunes;
+    uint64_t pickedTable, pickedNoisy, pickedKiller, pickedQuiet;
+    
+} SearchStats;
+
+typedef struct Thread {
+    SearchInfo * info;
+    TransTable * table;
+    uint64_t nodes, tbhits, nextTimeCheck;
+    SearchStats stats;
+    int evaluatingPlayer;
+    int depth, pvIndex;
+    PawnTable ptable;
+    HistoryTable history;
+    ContinuationTable continuation;
+    CaptureHistoryTable captureHistory;
+    uint16_t moveStack[MAX_HEIGHT];
+    int pieceStack[MAX_HEIGHT];
+    uint16_t killers[MAX_HEIGHT][2];
+    uint16_t excludedMoves[MAX_HEIGHT];
+    int evalStack[MAX_HEIGHT];
+    PVariation pvs[MAX_HEIGHT + 1];
+    
+} Thread;
 
 typedef struct MovePicker {
-    int isQuiescencePick, stage, split;
+    Thread * thread;
+    int height, isQuiescencePick, skipQuiets, skipBadNoisy;
+    int threshold, stage, split;
     int noisySize, badSize, quietSize;
     uint16_t tableMove, killer1, killer2;
     uint16_t moves[MAX_MOVES];
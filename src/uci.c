@@ -17,12 +17,17 @@
 */
 
 #include <inttypes.h>
+#include <pthread.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#include "bitbase.h"
 #include "board.h"
+#include "book.h"
+#include "cuckoo.h"
+#include "history.h"
 #include "magics.h"
 #include "masks.h"
 #include "move.h"
@@ -30,8 +35,12 @@
 #include "piece.h"
 #include "psqt.h"
 #include "search.h"
+#include "syzygy.h"
+#include "stats.h"
 #include "tests.h"
-#include "time.h"
+#include "texel.h"
+#include "timer.h"
+#include "timeman.h"
 #include "transposition.h"
 #include "types.h"
 #include "uci.h"
@@ -39,19 +48,31 @@
 
 char * startPos = "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
 
+pthread_mutex_t SearchLock = PTHREAD_MUTEX_INITIALIZER;
+
+pthread_cond_t SearchSignal = PTHREAD_COND_INITIALIZER;
+
 int main(){
     
-    int size, megabytes;
+    int size, megabytes, benchDepth, benchThreads, bookRandom = 1;
+    int searching = 0, multiPV = 1;
+    double elapsed;
+    uint16_t bestMove;
+    pthread_t pthreadsgo;
     Undo undo[1];
     SearchInfo info;
+    Thread * thread = calloc(1, sizeof(Thread));
     uint16_t moves[MAX_MOVES];
     char str[2048], moveStr[6], testStr[6], * ptr;
     
     // Initalze all components of the chess engine
     initalizeMagics();
     initalizeZorbist();
+    initalizeCuckoo();
+    initalizeSearch();
     initalizePSQT();
     initalizeMasks();
+    initalizeBitbases();
     initalizeBoard(&(info.board), startPos);
     initalizeTranspositionTable(&Table, 16);
     
@@ -59,6 +80,23 @@ int main(){
         
         getInput(str);
         
+        // The search runs alongside the input loop. Only isready and
+        // ponderhit are handled while searching; any other command,
+        // stop included, first ends the search and awaits its bestmove
+        if (   searching
+            && !stringEquals(str, "isready")
+            && !stringEquals(str, "ponderhit")){
+            
+            pthread_mutex_lock(&SearchLock);
+            info.searchIsPondering = 0;
+            info.terminateSearch = 1;
+            pthread_cond_signal(&SearchSignal);
+            pthread_mutex_unlock(&SearchLock);
+            
+            pthread_join(pthreadsgo, NULL);
+            searching = 0;
+        }
+        
         /* Non Universal Chess Interface commands */
         
         if (stringEquals(str, "runTestSuite")){
@@ -71,9 +109,37 @@ int main(){
         }
         
         else if (stringStartsWith(str, "bench")){
-            runBenchmark(atoi(str + 6));
+            
+            // Both the depth and number of threads are optional
+            benchDepth = (int)strtol(str + strlen("bench"), &ptr, 10);
+            benchThreads = (int)strtol(ptr, NULL, 10);
+            runBenchmark(benchDepth, benchThreads);
+        }
+        
+        else if (stringStartsWith(str, "savehash ")){
+            if (!saveTranspositionTable(&Table, str + strlen("savehash ")))
+                printf("info string unable to save hash to %s\n", str + strlen("savehash "));
+            fflush(stdout);
         }
         
+        else if (stringStartsWith(str, "loadhash ")){
+            if (!loadTranspositionTable(&Table, str + strlen("loadhash ")))
+                printf("info string unable to load hash from %s\n", str + strlen("loadhash "));
+            fflush(stdout);
+        }
+        
+        #ifdef TUNE
+        else if (stringStartsWith(str, "tune")){
+            runTexelTuning(str + 5);
+        }
+        #endif
+        
+        #ifdef STATS
+        else if (stringEquals(str, "stats")){
+            printStatistics(&thread->stats);
+        }
+        #endif
+        
         /* Universal Chess Interface commands
            Full documentation can be found here:
            http://wbec-ridderkerk.nl/html/UCIProtocol.html */
@@ -82,6 +148,12 @@ int main(){
             printf("id name Ethereal 8.16\n");
             printf("id author Andrew Grant\n");
             printf("option name Hash type spin default 16 min 1 max 2048\n");
+            printf("option name BookFile type string default <empty>\n");
+            printf("option name MoveOverhead type spin default %d min 0 max %d\n", MOVE_OVERHEAD_DEFAULT, MOVE_OVERHEAD_MAX);
+            printf("option name Ponder type check default false\n");
+            printf("option name MultiPV type spin default 1 min 1 max %d\n", MAX_MULTI_PV);
+            printf("option name BookRandom type check default true\n");
+            if (USE_SYZYGY) printf("option name SyzygyPath type string default <empty>\n");
             printf("uciok\n");
             fflush(stdout);
         }
@@ -91,6 +163,21 @@ int main(){
             fflush(stdout);
         } 
         
+        else if (stringEquals(str, "ponderhit")){
+            
+            // The opponent played the expected move. The search carries
+            // on with everything it has learned so far, but the time
+            // budgets are measured from this moment instead of the go
+            pthread_mutex_lock(&SearchLock);
+            elapsed = getRealTime() - info.clockStart;
+            info.clockStart += elapsed;
+            info.endTime1 += elapsed;
+            info.endTime2 += elapsed;
+            info.searchIsPondering = 0;
+            pthread_cond_signal(&SearchSignal);
+            pthread_mutex_unlock(&SearchLock);
+        }
+        
         else if (stringStartsWith(str, "setoption")){
             
             if (stringStartsWith(str, "setoption name Hash value")){
@@ -98,10 +185,48 @@ int main(){
                 destroyTranspositionTable(&Table);
                 initalizeTranspositionTable(&Table, megabytes);
             }
+            
+            else if (stringStartsWith(str, "setoption name MoveOverhead value")){
+                MoveOverhead = atoi(str + strlen("setoption name MoveOverhead value"));
+                MoveOverhead = MoveOverhead < 0 ? 0 : MoveOverhead > MOVE_OVERHEAD_MAX ? MOVE_OVERHEAD_MAX : MoveOverhead;
+            }
+            
+            else if (stringStartsWith(str, "setoption name MultiPV value")){
+                multiPV = atoi(str + strlen("setoption name MultiPV value"));
+                multiPV = multiPV < 1 ? 1 : multiPV > MAX_MULTI_PV ? MAX_MULTI_PV : multiPV;
+            }
+            
+            else if (stringStartsWith(str, "setoption name BookFile value")){
+                ptr = str + strlen("setoption name BookFile value");
+                while (*ptr == ' ') ptr++;
+                
+                if (*ptr == '\0' || stringEquals(ptr, "<empty>"))
+                    closeBook(&OpeningBook);
+                
+                else if (!openBook(&OpeningBook, ptr)){
+                    printf("info string unable to open book %s\n", ptr);
+                    fflush(stdout);
+                }
+            }
+            
+            else if (stringStartsWith(str, "setoption name BookRandom value")){
+                bookRandom = stringContains(str, "true");
+            }
+            
+            else if (stringStartsWith(str, "setoption name SyzygyPath value")){
+                ptr = str + strlen("setoption name SyzygyPath value");
+                while (*ptr == ' ') ptr++;
+                printf("info string found %d-man tablebases\n", initalizeSyzygy(ptr));
+                fflush(stdout);
+            }
         }
         
         else if (stringEquals(str, "ucinewgame")){
             clearTranspositionTable(&Table);
+            clearHistory(thread->history);
+            clearContinuationHistory(thread->continuation);
+            clearCaptureHistory(thread->captureHistory);
+            ExpectedClock = -1;
         } 
         
         else if (stringStartsWith(str, "position")){
@@ -158,8 +283,10 @@ int main(){
                 // Reset the history of hashes if we just reset
                 // the fifty move rule. This way, the numMoves
                 // can never be greated than ~100 (128)
-                if (info.board.fiftyMoveRule == 0)
+                if (info.board.fiftyMoveRule == 0){
                     info.board.numMoves = 0;
+                    memset(info.board.repetitionFilter, 0, sizeof(info.board.repetitionFilter));
+                }
             }
             
             // Reset has castled so that we only evaluate having
@@ -181,12 +308,29 @@ int main(){
             double binc = 0;
             double mtg = -1;
             int depth = -1;
+            int64_t nodes = -1;
             double movetime = -1;
             int infinite = -1;
+            int ponder = 0;
+            int searchmoves = 0;
+            uint16_t move;
+            
+            info.searchMovesSize = 0;
             
             // Parse all of the parameters in the go command
             for (ptr = strtok(NULL, " "); ptr != NULL; ptr = strtok(NULL, " ")){
                 
+                // Every legal move following searchmoves restricts the root.
+                // The list ends with the first token which is not a move
+                if (searchmoves){
+                    move = stringToMove(&info.board, ptr);
+                    if (move != NONE_MOVE){
+                        info.searchMoves[info.searchMovesSize++] = move;
+                        continue;
+                    }
+                    searchmoves = 0;
+                }
+                
                 if (stringEquals(ptr, "wtime")){
                     ptr = strtok(NULL, " ");
                     if (ptr == NULL) exit(EXIT_FAILURE);
@@ -223,6 +367,12 @@ int main(){
                     depth = atoi(ptr);
                 }
                 
+                else if (stringEquals(ptr, "nodes")){
+                    ptr = strtok(NULL, " ");
+                    if (ptr == NULL) exit(EXIT_FAILURE);
+                    nodes = strtoll(ptr, NULL, 10);
+                }
+                
                 else if (stringEquals(ptr, "movetime")){
                     ptr = strtok(NULL, " ");
                     if (ptr == NULL) exit(EXIT_FAILURE);
@@ -232,6 +382,14 @@ int main(){
                 else if (stringEquals(ptr, "infinite")){
                     infinite = 1;
                 }
+                
+                else if (stringEquals(ptr, "ponder")){
+                    ponder = 1;
+                }
+                
+                else if (stringEquals(ptr, "searchmoves")){
+                    searchmoves = 1;
+                }
             }
             
             
@@ -243,50 +401,69 @@ int main(){
             info.searchIsInfinite = 0;
             info.searchIsDepthLimited = 0;
             info.searchIsTimeLimited = 0;
+            info.searchIsTimeManaged = 0;
+            info.searchIsNodeLimited = 0;
+            info.searchIsSilent = 0;
+            info.searchIsPondering = ponder;
             info.depthLimit = 0;
+            info.multiPV = multiPV;
             info.terminateSearch = 0;
             info.startTime = getRealTime();
+            info.clockStart = info.startTime;
             
+            // Every limit given applies at once, and the search ends at
+            // whichever is reached first. Infinite searches ignore them all
             if (infinite == 1){
                 info.searchIsInfinite = 1;
             }
             
-            else if (depth != -1){
-                info.searchIsDepthLimited = 1;
-                info.depthLimit = depth;
-            }
-            
-            else if (movetime != -1){
-                info.searchIsTimeLimited = 1;
-                info.endTime1 = info.startTime + 20*movetime;
-                info.endTime2 = info.startTime + movetime;
-            }
-            
             else {
                 
-                info.searchIsTimeLimited = 1;
+                if (depth != -1){
+                    info.searchIsDepthLimited = 1;
+                    info.depthLimit = depth;
+                }
                 
-                // NOT USING REPEATING TIME CONTROL
-                if (mtg == -1){
-                    info.endTime1 = info.startTime + .5 * (time / 30);
-                    info.endTime2 = info.startTime + (time / 30) + inc;
+                if (nodes != -1){
+                    info.searchIsNodeLimited = 1;
+                    info.nodeLimit = (uint64_t)nodes;
                 }
                 
-                // USING REPEATING TIME CONTROL
-                else {
-                    info.endTime1 = info.startTime + .5 * (time / (mtg+2));
-                    info.endTime2 = info.startTime + (time / (mtg+2));
+                // A fixed time for the move replaces the clock
+                if (movetime != -1){
+                    info.searchIsTimeLimited = 1;
+                    info.endTime1 = info.startTime + 20*movetime;
+                    info.endTime2 = info.startTime + movetime;
                 }
+                
+                else if (time != -1)
+                    initalizeTimeManagement(&info, time, inc, mtg);
             }
             
-            // Execute the search and report the best move
-            moveToString(moveStr, getBestMove(&info));
-            printf("bestmove %s\n",moveStr);
-            fflush(stdout);
+            // Play from the opening book when possible, but never when
+            // asked to analyze, to ponder, or to consider only some moves
+            bestMove = NONE_MOVE;
+            if (infinite != 1 && !ponder && !info.searchMovesSize)
+                bestMove = probeBook(&OpeningBook, &info.board, bookRandom);
+            
+            if (bestMove != NONE_MOVE){
+                moveToString(moveStr, bestMove);
+                printf("bestmove %s\n", moveStr);
+                fflush(stdout);
+            }
+            
+            // Search in the background so we may still read input
+            else {
+                thread->info = &info;
+                thread->table = &Table;
+                pthread_create(&pthreadsgo, NULL, &uciGo, thread);
+                searching = 1;
+            }
         }
         
         else if (stringEquals(str, "quit")){
             destroyTranspositionTable(&Table);
+            closeBook(&OpeningBook);
             break;
         }
     }
@@ -294,6 +471,52 @@ int main(){
     return 1;
 }
 
+/**
+ * Execute the search requested by a go command and report the best move,
+ * as well as the reply we expect, which the GUI may let us ponder on. An
+ * infinite or pondering search may end on its own, but the best move is
+ * held back until the GUI sends a stop or a ponderhit.
+ *
+ * @param   argument    Thread to search with, holding the SearchInfo
+ *
+ * @return              Always NULL
+ */
+void * uciGo(void * argument){
+    
+    uint16_t bestMove, ponderMove;
+    char moveStr[6];
+    
+    Thread * thread = (Thread *)argument;
+    SearchInfo * info = thread->info;
+    
+    bestMove = getBestMove(thread, info, &ponderMove);
+    
+    pthread_mutex_lock(&SearchLock);
+    while ((info->searchIsInfinite || info->searchIsPondering) && !info->terminateSearch)
+        pthread_cond_wait(&SearchSignal, &SearchLock);
+    pthread_mutex_unlock(&SearchLock);
+    
+    moveToString(moveStr, bestMove);
+    printf("bestmove %s", moveStr);
+    
+    if (ponderMove != NONE_MOVE){
+        moveToString(moveStr, ponderMove);
+        printf(" ponder %s", moveStr);
+    }
+    
+    printf("\n");
+    fflush(stdout);
+    
+    // Learn the latency from what the clock reads next time
+    if (info->searchIsTimeManaged){
+        pthread_mutex_lock(&SearchLock);
+        recordMoveTime(info);
+        pthread_mutex_unlock(&SearchLock);
+    }
+    
+    return NULL;
+}
+
 int stringEquals(char * s1, char * s2){
     
     return strcmp(s1, s2) == 0;
@@ -321,6 +544,32 @@ void getInput(char * str){
     if (ptr != NULL) *ptr = '\0';
 }
 
+/**
+ * Find the legal move on the board which matches a move written in the
+ * long algebraic notation used by the Universal Chess Interface.
+ *
+ * @param   board   Board the move is to be played on
+ * @param   str     Move in long algebraic notation
+ *
+ * @return          Matching move, or NONE_MOVE if there is none
+ */
+uint16_t stringToMove(Board * board, char * str){
+    
+    int i, size = 0;
+    uint16_t moves[MAX_MOVES];
+    char moveStr[6];
+    
+    genAllLegalMoves(board, moves, &size);
+    
+    for (i = 0; i < size; i++){
+        moveToString(moveStr, moves[i]);
+        if (stringEquals(moveStr, str))
+            return moves[i];
+    }
+    
+    return NONE_MOVE;
+}
+
 void moveToString(char * str, uint16_t move){
     
     static char promoteDict[4] = {'n', 'b', 'r', 'q'};
@@ -19,10 +19,20 @@
 #ifndef _UCI_H
 #define _UCI_H
 
+#include <pthread.h>
+#include <stdint.h>
+
+#include "types.h"
+
+void * uciGo(void * argument);
 int stringEquals(char * s1, char * s2);
 int stringStartsWith(char * str, char * key);
 int stringContains(char * str, char * key);
 void getInput(char * str);
+uint16_t stringToMove(Board * board, char * str);
 void moveToString(char * str, uint16_t move);
 
+// Guards the clock and deadlines of a search, which ponderhit may move
+extern pthread_mutex_t SearchLock;
+
 #endif
\ No newline at end of file
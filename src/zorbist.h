@@ -27,10 +27,18 @@
 #define ENPASS (3)
 #define TURN   (6)
 
+#define POLYGLOT_CASTLE (768)
+#define POLYGLOT_ENPASS (772)
+#define POLYGLOT_TURN   (780)
+#define POLYGLOT_KEY_NB (781)
+
 void initalizeZorbist();
 uint64_t genRandomBitstring();
+uint64_t polyglotKey(Board * board);
+uint64_t zorbistFingerprint();
 
 extern uint64_t ZorbistKeys[32][SQUARE_NB];
 extern uint64_t PawnKeys[32][SQUARE_NB];
+extern uint64_t PolyglotKeys[POLYGLOT_KEY_NB];
 
 #endif
\ No newline at end of file